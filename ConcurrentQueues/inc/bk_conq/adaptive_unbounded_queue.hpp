@@ -0,0 +1,110 @@
+/*
+ * File:   adaptive_unbounded_queue.hpp
+ * Author: Barath Kannan
+ * An unbounded queue that switches between a single queue Q and a dynamic multi
+ * queue of Q subqueues according to producer contention. It starts on the single
+ * queue, which is best with few writers, and fans out to the subqueues once several
+ * producers are seen enqueueing at the same time (see details::contention_sampler).
+ * It collapses back to the single queue once a lone producer remains. Subqueues are
+ * only constructed once producers use them.
+ * Ordering: each structure keeps its own ordering guarantees. After a switch,
+ * consumers drain the structure that was left before the one that was entered, so
+ * a producer's items from before a switch are dequeued ahead of its items from after
+ * it. The exception is a producer that enqueues to the old structure after the drain
+ * has completed because it had not yet observed the switch. Consumers still probe the
+ * old structure when the current one is empty, so such items are never lost, but
+ * they may be dequeued after later items.
+ * Created on 18 October 2026 4:55 PM
+ */
+
+#ifndef BK_CONQ_ADAPTIVE_UNBOUNDED_QUEUE_HPP
+#define BK_CONQ_ADAPTIVE_UNBOUNDED_QUEUE_HPP
+
+#include <atomic>
+#include <type_traits>
+#include <bk_conq/unbounded_queue.hpp>
+#include <bk_conq/layout.hpp>
+#include <bk_conq/multi_unbounded_queue.hpp>
+#include <bk_conq/details/queue_traits.hpp>
+#include <bk_conq/details/contention_sampler.hpp>
+
+namespace bk_conq {
+
+template<typename Q, typename LAYOUT = isolated_layout>
+class adaptive_unbounded_queue : public unbounded_queue<typename details::queue_traits<Q>::value_type, adaptive_unbounded_queue<Q, LAYOUT>> {
+    using T = typename details::queue_traits<Q>::value_type;
+    friend unbounded_queue<T, adaptive_unbounded_queue<Q, LAYOUT>>;
+    static_assert(std::is_base_of<bk_conq::unbounded_queue_tag, Q>::value, "Q must be an unbounded queue");
+public:
+    adaptive_unbounded_queue(size_t max_subqueues) : _multi(max_subqueues) {}
+
+    adaptive_unbounded_queue(const adaptive_unbounded_queue&) = delete;
+    void operator=(const adaptive_unbounded_queue&) = delete;
+
+    //true while enqueues are spread over the subqueues
+    bool fanned_out() const {
+        return _state.load(std::memory_order_relaxed) & multi_bit;
+    }
+
+protected:
+    template <typename R>
+    void sp_enqueue_impl(R&& input) {
+        mp_enqueue_impl(std::forward<R>(input));
+    }
+
+    template <typename R>
+    void mp_enqueue_impl(R&& input) {
+        adapt();
+        if (_state.load(std::memory_order_relaxed) & multi_bit) _multi.mp_enqueue(std::forward<R>(input));
+        else _single.mp_enqueue(std::forward<R>(input));
+    }
+
+    bool sc_dequeue_impl(T& output) {
+        return dequeue([&](auto& q) { return q.sc_dequeue(output); });
+    }
+
+    bool mc_dequeue_impl(T& output) {
+        return dequeue([&](auto& q) { return q.mc_dequeue(output); });
+    }
+
+    bool mc_dequeue_uncontended_impl(T& output) {
+        return dequeue([&](auto& q) { return q.mc_dequeue_uncontended(output); });
+    }
+
+private:
+    static constexpr size_t multi_bit = 1;
+    //set on a switch until a consumer finds the structure that was left empty
+    static constexpr size_t draining_bit = 2;
+
+    void adapt() {
+        auto decision = _sampler.sample();
+        if (decision == details::contention_sampler::none) return;
+        bool multi = decision == details::contention_sampler::fan_out;
+        size_t state = _state.load(std::memory_order_relaxed);
+        if (static_cast<bool>(state & multi_bit) == multi) return;
+        _state.compare_exchange_strong(state, (multi ? multi_bit : 0) | draining_bit, std::memory_order_relaxed);
+    }
+
+    template <typename F>
+    bool dequeue(F&& op) {
+        size_t state = _state.load(std::memory_order_relaxed);
+        bool multi = state & multi_bit;
+        if (state & draining_bit) {
+            if (multi ? op(_single) : op(_multi)) return true;
+            _state.compare_exchange_strong(state, state & ~draining_bit, std::memory_order_relaxed);
+            return multi ? op(_multi) : op(_single);
+        }
+        if (multi ? op(_multi) : op(_single)) return true;
+        //items from producers that had not yet observed the last switch
+        return multi ? op(_single) : op(_multi);
+    }
+
+    Q _single;
+    multi_unbounded_queue<Q, LAYOUT, details::dynamic_subqueues> _multi;
+    alignas(details::layout_alignment<LAYOUT, std::atomic<size_t>>::value) std::atomic<size_t> _state{ 0 };
+    alignas(details::layout_alignment<LAYOUT, details::contention_sampler>::value) details::contention_sampler _sampler;
+};
+
+}//namespace bk_conq
+
+#endif /* BK_CONQ_ADAPTIVE_UNBOUNDED_QUEUE_HPP */
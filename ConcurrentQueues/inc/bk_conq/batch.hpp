@@ -0,0 +1,38 @@
+/*
+* File:   batch.hpp
+* Author: Barath Kannan
+* A fixed capacity group of items, used as the element type of the queue wrapped by
+* the batching adapters so that a whole batch is published with a single enqueue.
+* Created on 18 October 2026 5:20 PM
+*/
+
+#ifndef BK_CONQ_BATCH_HPP
+#define BK_CONQ_BATCH_HPP
+
+#include <array>
+#include <type_traits>
+
+namespace bk_conq {
+
+template <typename T, size_t SIZE>
+struct batch {
+    static_assert(SIZE > 0, "a batch must hold at least one item");
+    using value_type = T;
+    static constexpr size_t capacity = SIZE;
+
+    std::array<T, SIZE> items;
+    size_t count{ 0 };
+};
+
+namespace details {
+
+template <typename B>
+struct is_batch : std::false_type {};
+
+template <typename T, size_t SIZE>
+struct is_batch<batch<T, SIZE>> : std::true_type {};
+
+}//namespace details
+}//namespace bk_conq
+
+#endif // BK_CONQ_BATCH_HPP
@@ -0,0 +1,177 @@
+/*
+ * File:   batching_bounded_queue.hpp
+ * Author: Barath Kannan
+ * Buffers enqueues in a thread-local batch and publishes the batch to the wrapped
+ * queue Q with a single enqueue, which must hold bk_conq::batch elements, so the
+ * capacity of Q is counted in batches. A batch is published when it fills, when an
+ * enqueue finds that its first item has waited longer than the maximum linger (see
+ * set_max_linger), when the producer calls flush(), and when the producing thread
+ * exits. A batch that cannot be published because Q is full stays with its producer
+ * and is retried on the next enqueue, which fails only while the batch is full.
+ * The linger is only checked by the producer's own enqueues, so a producer that stops
+ * enqueueing without flushing holds its items until it exits. Consumers take a whole
+ * batch at a time and serve further dequeues from it, and a consumer that exits
+ * returns the items it has not dequeued to the back of the queue. Batches left by
+ * exiting threads while Q is full are kept aside and dequeued once Q is empty.
+ * Items of one producer keep their order, except for items returned by an exiting
+ * consumer or kept aside, which may follow batches published after them.
+ * Batches are always published to Q with mp_enqueue, even by the sp operations, since
+ * an exiting consumer may return its items while a single producer is publishing.
+ * The sp operations therefore only differ from the mp operations in name, as the
+ * thread-local batches already keep producers apart.
+ * Created on 18 October 2026 5:20 PM
+ */
+
+#ifndef BK_CONQ_BATCHING_BOUNDED_QUEUE_HPP
+#define BK_CONQ_BATCHING_BOUNDED_QUEUE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <type_traits>
+#include <utility>
+#include <bk_conq/bounded_queue.hpp>
+#include <bk_conq/batch.hpp>
+#include <bk_conq/details/tlos.hpp>
+#include <bk_conq/details/queue_traits.hpp>
+
+namespace bk_conq {
+
+template<typename Q>
+class batching_bounded_queue : public bounded_queue<typename details::queue_traits<Q>::value_type::value_type, batching_bounded_queue<Q>> {
+    using batch_t = typename details::queue_traits<Q>::value_type;
+    using T = typename batch_t::value_type;
+    using clock = std::chrono::steady_clock;
+    friend bounded_queue<T, batching_bounded_queue<Q>>;
+    static_assert(std::is_base_of<bk_conq::bounded_queue_tag, Q>::value, "Q must be a bounded queue");
+    static_assert(details::is_batch<batch_t>::value, "Q must hold bk_conq::batch elements");
+public:
+    //the arguments are passed to Q
+    template <typename... Args>
+    batching_bounded_queue(Args&&... args) :
+        _q(std::forward<Args>(args)...),
+        _producer([]() { return producer_t{}; }, [&](producer_t&& producer) { publish_or_set_aside(producer.pending); }),
+        _consumer([]() { return consumer_t{}; }, [&](consumer_t&& consumer) { return_prefetched(consumer); })
+    {}
+
+    batching_bounded_queue(const batching_bounded_queue&) = delete;
+    void operator=(const batching_bounded_queue&) = delete;
+
+    //the longest an enqueued item waits for its batch to fill, checked on each enqueue
+    void set_max_linger(std::chrono::nanoseconds linger) {
+        _max_linger.store(std::chrono::duration_cast<clock::duration>(linger).count(), std::memory_order_relaxed);
+    }
+
+    //publishes the calling thread's partial batch, returns false if Q is full
+    bool flush() {
+        return publish(_producer.get().pending);
+    }
+
+protected:
+    template <typename R>
+    bool sp_enqueue_impl(R&& input) {
+        return enqueue(std::forward<R>(input));
+    }
+
+    template <typename R>
+    bool mp_enqueue_impl(R&& input) {
+        return enqueue(std::forward<R>(input));
+    }
+
+    bool sc_dequeue_impl(T& output) {
+        return dequeue(output, [&](batch_t& b) { return _q.sc_dequeue(b); });
+    }
+
+    bool mc_dequeue_impl(T& output) {
+        return dequeue(output, [&](batch_t& b) { return _q.mc_dequeue(b); });
+    }
+
+    bool mc_dequeue_uncontended_impl(T& output) {
+        return dequeue(output, [&](batch_t& b) { return _q.mc_dequeue_uncontended(b); });
+    }
+
+private:
+    struct producer_t {
+        batch_t pending;
+        clock::time_point first;
+    };
+
+    struct consumer_t {
+        batch_t prefetched;
+        size_t next{ 0 };
+    };
+
+    template <typename R>
+    bool enqueue(R&& input) {
+        auto& producer = _producer.get();
+        auto& pending = producer.pending;
+        //a full batch was left by an earlier enqueue that found Q full
+        if (pending.count == batch_t::capacity && !publish(pending)) return false;
+        auto now = clock::now();
+        if (pending.count == 0) producer.first = now;
+        pending.items[pending.count++] = std::forward<R>(input);
+        if (pending.count == batch_t::capacity || (now - producer.first).count() >= _max_linger.load(std::memory_order_relaxed)) {
+            publish(pending);
+        }
+        return true;
+    }
+
+    template <typename F>
+    bool dequeue(T& output, F&& take) {
+        auto& consumer = _consumer.get();
+        if (consumer.next == consumer.prefetched.count) {
+            if (!take(consumer.prefetched) && !take_set_aside(consumer.prefetched)) return false;
+            consumer.next = 0;
+        }
+        output = std::move(consumer.prefetched.items[consumer.next++]);
+        return true;
+    }
+
+    //always a multi-producer enqueue, since exiting consumers publish alongside the producers
+    bool publish(batch_t& pending) {
+        if (pending.count == 0) return true;
+        if (!_q.mp_enqueue(std::move(pending))) return false;
+        pending.count = 0;
+        return true;
+    }
+
+    //called for threads that exit, which cannot wait for Q to have room
+    void publish_or_set_aside(batch_t& pending) {
+        if (publish(pending)) return;
+        std::lock_guard<std::mutex> lock(_set_aside_mutex);
+        _set_aside.push_back(std::move(pending));
+        _set_aside_count.store(_set_aside.size(), std::memory_order_release);
+    }
+
+    bool take_set_aside(batch_t& output) {
+        if (_set_aside_count.load(std::memory_order_acquire) == 0) return false;
+        std::lock_guard<std::mutex> lock(_set_aside_mutex);
+        if (_set_aside.empty()) return false;
+        output = std::move(_set_aside.back());
+        _set_aside.pop_back();
+        _set_aside_count.store(_set_aside.size(), std::memory_order_release);
+        return true;
+    }
+
+    void return_prefetched(consumer_t& consumer) {
+        if (consumer.next == consumer.prefetched.count) return;
+        batch_t remaining;
+        for (size_t i = consumer.next; i < consumer.prefetched.count; ++i) {
+            remaining.items[remaining.count++] = std::move(consumer.prefetched.items[i]);
+        }
+        publish_or_set_aside(remaining);
+    }
+
+    Q _q;
+    std::atomic<clock::rep> _max_linger{ std::chrono::duration_cast<clock::duration>(std::chrono::microseconds(100)).count() };
+    std::atomic<size_t> _set_aside_count{ 0 };
+    std::mutex _set_aside_mutex;
+    std::vector<batch_t> _set_aside;
+    details::tlos<producer_t, batching_bounded_queue<Q>> _producer;
+    details::tlos<consumer_t, batching_bounded_queue<Q>> _consumer;
+};
+
+}//namespace bk_conq
+
+#endif /* BK_CONQ_BATCHING_BOUNDED_QUEUE_HPP */
@@ -0,0 +1,147 @@
+/*
+ * File:   batching_unbounded_queue.hpp
+ * Author: Barath Kannan
+ * Buffers enqueues in a thread-local batch and publishes the batch to the wrapped
+ * queue Q with a single enqueue, which must hold bk_conq::batch elements. A batch is
+ * published when it fills, when an enqueue finds that its first item has waited
+ * longer than the maximum linger (see set_max_linger), when the producer calls
+ * flush(), and when the producing thread exits. The linger is only checked by the
+ * producer's own enqueues, so a producer that stops enqueueing without flushing
+ * holds its items until it exits. Consumers take a whole batch at a time and serve
+ * further dequeues from it, and a consumer that exits returns the items it has not
+ * dequeued to the back of the queue.
+ * Items of one producer keep their order, except for items returned by an exiting
+ * consumer, which follow the batches published before their return.
+ * Batches are always published to Q with mp_enqueue, even by the sp operations, since
+ * an exiting consumer may return its items while a single producer is publishing.
+ * The sp operations therefore only differ from the mp operations in name, as the
+ * thread-local batches already keep producers apart.
+ * Created on 18 October 2026 5:20 PM
+ */
+
+#ifndef BK_CONQ_BATCHING_UNBOUNDED_QUEUE_HPP
+#define BK_CONQ_BATCHING_UNBOUNDED_QUEUE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <type_traits>
+#include <utility>
+#include <bk_conq/unbounded_queue.hpp>
+#include <bk_conq/batch.hpp>
+#include <bk_conq/details/tlos.hpp>
+#include <bk_conq/details/queue_traits.hpp>
+
+namespace bk_conq {
+
+template<typename Q>
+class batching_unbounded_queue : public unbounded_queue<typename details::queue_traits<Q>::value_type::value_type, batching_unbounded_queue<Q>> {
+    using batch_t = typename details::queue_traits<Q>::value_type;
+    using T = typename batch_t::value_type;
+    using clock = std::chrono::steady_clock;
+    friend unbounded_queue<T, batching_unbounded_queue<Q>>;
+    static_assert(std::is_base_of<bk_conq::unbounded_queue_tag, Q>::value, "Q must be an unbounded queue");
+    static_assert(details::is_batch<batch_t>::value, "Q must hold bk_conq::batch elements");
+public:
+    //the arguments are passed to Q
+    template <typename... Args>
+    batching_unbounded_queue(Args&&... args) :
+        _q(std::forward<Args>(args)...),
+        _producer([]() { return producer_t{}; }, [&](producer_t&& producer) { publish(producer.pending); }),
+        _consumer([]() { return consumer_t{}; }, [&](consumer_t&& consumer) { return_prefetched(consumer); })
+    {}
+
+    batching_unbounded_queue(const batching_unbounded_queue&) = delete;
+    void operator=(const batching_unbounded_queue&) = delete;
+
+    //the longest an enqueued item waits for its batch to fill, checked on each enqueue
+    void set_max_linger(std::chrono::nanoseconds linger) {
+        _max_linger.store(std::chrono::duration_cast<clock::duration>(linger).count(), std::memory_order_relaxed);
+    }
+
+    //publishes the calling thread's partial batch
+    void flush() {
+        publish(_producer.get().pending);
+    }
+
+protected:
+    template <typename R>
+    void sp_enqueue_impl(R&& input) {
+        enqueue(std::forward<R>(input));
+    }
+
+    template <typename R>
+    void mp_enqueue_impl(R&& input) {
+        enqueue(std::forward<R>(input));
+    }
+
+    bool sc_dequeue_impl(T& output) {
+        return dequeue(output, [&](batch_t& b) { return _q.sc_dequeue(b); });
+    }
+
+    bool mc_dequeue_impl(T& output) {
+        return dequeue(output, [&](batch_t& b) { return _q.mc_dequeue(b); });
+    }
+
+    bool mc_dequeue_uncontended_impl(T& output) {
+        return dequeue(output, [&](batch_t& b) { return _q.mc_dequeue_uncontended(b); });
+    }
+
+private:
+    struct producer_t {
+        batch_t pending;
+        clock::time_point first;
+    };
+
+    struct consumer_t {
+        batch_t prefetched;
+        size_t next{ 0 };
+    };
+
+    template <typename R>
+    void enqueue(R&& input) {
+        auto& producer = _producer.get();
+        auto& pending = producer.pending;
+        auto now = clock::now();
+        if (pending.count == 0) producer.first = now;
+        pending.items[pending.count++] = std::forward<R>(input);
+        if (pending.count == batch_t::capacity || (now - producer.first).count() >= _max_linger.load(std::memory_order_relaxed)) {
+            publish(pending);
+        }
+    }
+
+    template <typename F>
+    bool dequeue(T& output, F&& take) {
+        auto& consumer = _consumer.get();
+        if (consumer.next == consumer.prefetched.count) {
+            if (!take(consumer.prefetched)) return false;
+            consumer.next = 0;
+        }
+        output = std::move(consumer.prefetched.items[consumer.next++]);
+        return true;
+    }
+
+    //always a multi-producer enqueue, since exiting consumers publish alongside the producers
+    void publish(batch_t& pending) {
+        if (pending.count == 0) return;
+        _q.mp_enqueue(std::move(pending));
+        pending.count = 0;
+    }
+
+    void return_prefetched(consumer_t& consumer) {
+        if (consumer.next == consumer.prefetched.count) return;
+        batch_t remaining;
+        for (size_t i = consumer.next; i < consumer.prefetched.count; ++i) {
+            remaining.items[remaining.count++] = std::move(consumer.prefetched.items[i]);
+        }
+        publish(remaining);
+    }
+
+    Q _q;
+    std::atomic<clock::rep> _max_linger{ std::chrono::duration_cast<clock::duration>(std::chrono::microseconds(100)).count() };
+    details::tlos<producer_t, batching_unbounded_queue<Q>> _producer;
+    details::tlos<consumer_t, batching_unbounded_queue<Q>> _consumer;
+};
+
+}//namespace bk_conq
+
+#endif /* BK_CONQ_BATCHING_UNBOUNDED_QUEUE_HPP */
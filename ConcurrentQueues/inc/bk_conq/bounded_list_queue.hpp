@@ -7,6 +7,11 @@
  * as a linked list, where nodes are stored in a freelist after being dequeued.
  * Enqueue operations will attempt to acquire items from the freelist or return false
  * if no node is available.
+ * All nodes are held in one vector and are linked by their 32 bit index in it, rather
+ * than by pointer, so the queue holds at most 2^32 - 1 nodes. The index at which the
+ * freelist is popped is kept with a version in one 64 bit word, and the version is
+ * advanced by every pop, so a pop that raced with the node being popped and freed
+ * again fails instead of installing a stale next index.
  * Created on 30 January 2017, 08:36 PM
  */
 
@@ -14,23 +19,26 @@
 #define BK_CONQ_BOUNDEDLISTQUEUE_HPP
 
 #include <atomic>
+#include <cstdint>
+#include <stdexcept>
 #include <thread>
+#include <vector>
 #include <initializer_list>
 #include <bk_conq/bounded_queue.hpp>
+#include <bk_conq/layout.hpp>
 
 namespace bk_conq {
-template<typename T>
-class bounded_list_queue : public bounded_queue<T, bounded_list_queue<T>> {
-    friend bounded_queue<T, bounded_list_queue<T>>;
+template<typename T, typename LAYOUT = isolated_layout>
+class bounded_list_queue : public bounded_queue<T, bounded_list_queue<T, LAYOUT>> {
+    friend bounded_queue<T, bounded_list_queue<T, LAYOUT>>;
 public:
-    bounded_list_queue(size_t N) : _data(N) {
-        _free_list_head.store(&_data[1], std::memory_order_relaxed);
-        _free_list_tail.store(_free_list_head.load(std::memory_order_relaxed));
+    bounded_list_queue(size_t N) : _data(check_size(N)) {
+        //node 0 is the dummy of the queue, the freelist is popped from node N - 1 down to its dummy, node 1
+        _free_list_head.store(1, std::memory_order_relaxed);
         for (size_t i = 2; i < N; ++i) {
-            list_node_t* tail = &_data[i];
-            tail->next.store(_free_list_tail.load(std::memory_order_relaxed));
-            _free_list_tail.store(tail);
+            _data[i].next.store(static_cast<uint32_t>(i - 1), std::memory_order_relaxed);
         }
+        _free_list_tail.store(tagged(static_cast<uint32_t>(N - 1), 0), std::memory_order_relaxed);
     }
 
     virtual ~bounded_list_queue() {}
@@ -38,35 +46,39 @@ public:
     bounded_list_queue(const bounded_list_queue&) = delete;
     void operator=(const bounded_list_queue&) = delete;
 
+    //the size of each node held by the queue
+    static constexpr size_t node_bytes() {
+        return sizeof(list_node_t);
+    }
 
 protected:
     template <typename R>
     bool sp_enqueue_impl(R&& input) {
-        list_node_t *node = freelist_try_dequeue();
-        if (!node) return false;
-        node->data = std::forward<R>(input);
-        node->next.store(nullptr, std::memory_order_relaxed);
-        _head.load(std::memory_order_relaxed)->next.store(node, std::memory_order_release);
+        uint32_t node = freelist_try_dequeue();
+        if (node == null_index) return false;
+        _data[node].data = std::forward<R>(input);
+        _data[node].next.store(null_index, std::memory_order_relaxed);
+        _data[_head.load(std::memory_order_relaxed)].next.store(node, std::memory_order_release);
         _head.store(node, std::memory_order_relaxed);
         return true;
     }
 
     template <typename R>
     bool mp_enqueue_impl(R&& input) {
-        list_node_t *node = freelist_try_dequeue();
-        if (!node) return false;
-        node->data = std::forward<R>(input);
-        node->next.store(nullptr, std::memory_order_relaxed);
-        list_node_t* prev_head = _head.exchange(node, std::memory_order_acq_rel);
-        prev_head->next.store(node, std::memory_order_release);
+        uint32_t node = freelist_try_dequeue();
+        if (node == null_index) return false;
+        _data[node].data = std::forward<R>(input);
+        _data[node].next.store(null_index, std::memory_order_relaxed);
+        uint32_t prev_head = _head.exchange(node, std::memory_order_acq_rel);
+        _data[prev_head].next.store(node, std::memory_order_release);
         return true;
     }
 
     bool sc_dequeue_impl(T& output) {
-        list_node_t* tail = _tail.load(std::memory_order_relaxed);
-        list_node_t* next = tail->next.load(std::memory_order_acquire);
-        if (!next) return false;
-        output = std::move(next->data);
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        uint32_t next = _data[tail].next.load(std::memory_order_acquire);
+        if (next == null_index) return false;
+        output = std::move(_data[next].data);
         _tail.store(next, std::memory_order_release);
         freelist_enqueue(tail);
         return true;
@@ -74,16 +86,16 @@ protected:
 
     //yield spin on dequeue contention
     bool mc_dequeue_impl(T& output) {
-        list_node_t *tail;
-        for (tail = _tail.exchange(nullptr, std::memory_order_acq_rel); !tail; tail = _tail.exchange(nullptr, std::memory_order_acq_rel)) {
+        uint32_t tail;
+        for (tail = _tail.exchange(null_index, std::memory_order_acq_rel); tail == null_index; tail = _tail.exchange(null_index, std::memory_order_acq_rel)) {
             std::this_thread::yield();
         }
-        list_node_t *next = tail->next.load(std::memory_order_acquire);
-        if (!next) {
+        uint32_t next = _data[tail].next.load(std::memory_order_acquire);
+        if (next == null_index) {
             _tail.exchange(tail, std::memory_order_acq_rel);
             return false;
         }
-        output = std::move(next->data);
+        output = std::move(_data[next].data);
         _tail.store(next, std::memory_order_release);
         freelist_enqueue(tail);
         return true;
@@ -91,50 +103,60 @@ protected:
 
     //return false on dequeue contention
     bool mc_dequeue_uncontended_impl(T& output) {
-        list_node_t *tail = _tail.exchange(nullptr, std::memory_order_acq_rel);
-        if (!tail) return false;
-        list_node_t *next = tail->next.load(std::memory_order_acquire);
-        if (!next) {
+        uint32_t tail = _tail.exchange(null_index, std::memory_order_acq_rel);
+        if (tail == null_index) return false;
+        uint32_t next = _data[tail].next.load(std::memory_order_acquire);
+        if (next == null_index) {
             _tail.exchange(tail, std::memory_order_acq_rel);
             return false;
         }
-        output = std::move(next->data);
+        output = std::move(_data[next].data);
         _tail.store(next, std::memory_order_release);
         freelist_enqueue(tail);
         return true;
     }
 
 private:
+    //the end of a list, and the tail of the queue while a consumer holds it
+    static constexpr uint32_t null_index = UINT32_MAX;
+
     struct list_node_t {
         T data;
-        std::atomic<list_node_t*> next{ nullptr };
-
-        template<typename R>
-        list_node_t(R&& input) : data(input) {}
-        list_node_t() {}
+        std::atomic<uint32_t> next{ null_index };
     };
 
-    inline void freelist_enqueue(list_node_t *item) {
-        item->next.store(nullptr, std::memory_order_relaxed);
-        list_node_t * free_list_prev_head = _free_list_head.exchange(item, std::memory_order_acq_rel);
-        free_list_prev_head->next.store(item, std::memory_order_release);
+    static size_t check_size(size_t N) {
+        if (N < 2 || N > null_index) {
+            throw std::length_error("size of bounded_list_queue must be between 2 and 2^32 - 1");
+        }
+        return N;
+    }
+
+    static uint64_t tagged(uint32_t index, uint32_t version) {
+        return (static_cast<uint64_t>(version) << 32) | index;
+    }
+
+    inline void freelist_enqueue(uint32_t item) {
+        _data[item].next.store(null_index, std::memory_order_relaxed);
+        uint32_t free_list_prev_head = _free_list_head.exchange(item, std::memory_order_acq_rel);
+        _data[free_list_prev_head].next.store(item, std::memory_order_release);
     }
 
-    inline list_node_t* freelist_try_dequeue() {
-        list_node_t* node = _free_list_tail.load(std::memory_order_relaxed);
-        for (list_node_t *next = node->next.load(std::memory_order_acquire); next != nullptr; next = node->next.load(std::memory_order_acquire)) {
-            if (_free_list_tail.compare_exchange_strong(node, next)) return node;
+    inline uint32_t freelist_try_dequeue() {
+        uint64_t tail = _free_list_tail.load(std::memory_order_acquire);
+        while (true) {
+            uint32_t node = static_cast<uint32_t>(tail);
+            uint32_t next = _data[node].next.load(std::memory_order_acquire);
+            if (next == null_index) return null_index;
+            if (_free_list_tail.compare_exchange_weak(tail, tagged(next, static_cast<uint32_t>(tail >> 32) + 1), std::memory_order_acq_rel, std::memory_order_acquire)) return node;
         }
-        return nullptr;
     }
 
     std::vector<list_node_t> _data;
-    char _padding2[64];
-    std::atomic<list_node_t*> _head{ &_data[0] };
-    std::atomic<list_node_t*> _free_list_tail{ nullptr };
-    char _padding[64];
-    std::atomic<list_node_t*> _tail{ _head.load(std::memory_order_relaxed) };
-    std::atomic<list_node_t*> _free_list_head{ nullptr };
+    alignas(details::layout_alignment<LAYOUT, std::atomic<uint64_t>>::value) std::atomic<uint32_t> _head{ 0 };
+    std::atomic<uint64_t> _free_list_tail{ 0 };
+    alignas(details::layout_alignment<LAYOUT, std::atomic<uint64_t>>::value) std::atomic<uint32_t> _tail{ 0 };
+    std::atomic<uint32_t> _free_list_head{ 0 };
 };
 }//namespace bk_conq
 
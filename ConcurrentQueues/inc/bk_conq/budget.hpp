@@ -0,0 +1,101 @@
+/*
+ * File:   budget.hpp
+ * Author: Barath Kannan
+ * Memory budget policies for the list queue. A budget policy decides whether the
+ * queue may allocate another block of nodes once its freelist is empty, and with it
+ * whether the queue is bounded.
+ * unlimited_budget always allocates, so enqueues never fail and the queue is
+ * unbounded. It holds no state.
+ * byte_budget only allocates a block while the node bytes allocated so far are below
+ * the budget given to the queue on construction, so the allocated bytes exceed the
+ * budget by less than one block. Once the freelist is empty and the budget is used
+ * up, enqueues fail until consumers free nodes, so a stalled consumer stops producers
+ * instead of exhausting memory, and the queue is bounded. The budget is only checked
+ * when the freelist is empty. The bytes held by queued items are accounted in sharded
+ * counters, which keeps the accounting off shared cache lines.
+ * Created on 18 October 2026 9:10 PM
+ */
+
+#ifndef BK_CONQ_BUDGET_HPP
+#define BK_CONQ_BUDGET_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <bk_conq/layout.hpp>
+#include <bk_conq/details/sharded_counter.hpp>
+
+namespace bk_conq {
+
+struct unlimited_budget {
+    static constexpr bool bounded = false;
+
+    template <typename LAYOUT>
+    class state {
+    protected:
+        void allocated(size_t) {}
+
+        bool try_allocate(size_t) {
+            return true;
+        }
+
+        void acquired(size_t) {}
+
+        void released(size_t) {}
+    };
+};
+
+struct byte_budget {
+    static constexpr bool bounded = true;
+
+    template <typename LAYOUT>
+    class state {
+    public:
+        state(size_t budget_bytes) : _budget(budget_bytes) {}
+
+        //node bytes allocated, never more than the budget plus one block
+        size_t bytes_allocated() const {
+            return _allocated.load(std::memory_order_relaxed);
+        }
+
+        //node bytes holding queued items, approximate while operations are in progress
+        size_t bytes_in_use() const {
+            int64_t bytes = _in_use.load();
+            return bytes > 0 ? static_cast<size_t>(bytes) : 0;
+        }
+
+        size_t budget() const {
+            return _budget;
+        }
+
+    protected:
+        void allocated(size_t bytes) {
+            _allocated.fetch_add(bytes, std::memory_order_relaxed);
+        }
+
+        //claims the bytes of one block if the budget has not been used up
+        bool try_allocate(size_t bytes) {
+            size_t allocated = _allocated.load(std::memory_order_relaxed);
+            do {
+                if (allocated >= _budget) return false;
+            } while (!_allocated.compare_exchange_weak(allocated, allocated + bytes, std::memory_order_relaxed));
+            return true;
+        }
+
+        void acquired(size_t bytes) {
+            _in_use.add(static_cast<int64_t>(bytes));
+        }
+
+        void released(size_t bytes) {
+            _in_use.add(-static_cast<int64_t>(bytes));
+        }
+
+    private:
+        const size_t _budget;
+        alignas(details::layout_alignment<LAYOUT, std::atomic<size_t>>::value) std::atomic<size_t> _allocated{ 0 };
+        details::sharded_counter<LAYOUT> _in_use;
+    };
+};
+
+}//namespace bk_conq
+
+#endif /* BK_CONQ_BUDGET_HPP */
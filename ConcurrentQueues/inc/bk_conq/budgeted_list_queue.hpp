@@ -0,0 +1,24 @@
+/*
+ * File:   budgeted_list_queue.hpp
+ * Author: Barath Kannan
+ * This is a bounded multi-producer multi-consumer queue with a soft memory budget.
+ * It is the list queue with the byte_budget policy, which only allocates a block of
+ * nodes while the node bytes allocated so far are below the budget, so that enqueue
+ * operations return false once the freelist is empty and the budget is used up, and a
+ * stalled consumer stops producers instead of exhausting memory (see budget.hpp).
+ * Created on 18 October 2026 9:10 PM
+ */
+
+#ifndef BK_CONQ_BUDGETEDLISTQUEUE_HPP
+#define BK_CONQ_BUDGETEDLISTQUEUE_HPP
+
+#include <bk_conq/budget.hpp>
+#include <bk_conq/layout.hpp>
+#include <bk_conq/list_queue.hpp>
+
+namespace bk_conq {
+template<typename T, typename LAYOUT = isolated_layout>
+using budgeted_list_queue = list_queue<T, LAYOUT, byte_budget>;
+}//namespace bk_conq
+
+#endif /* BK_CONQ_BUDGETEDLISTQUEUE_HPP */
@@ -0,0 +1,225 @@
+/*
+ * File:   byte_ring.hpp
+ * Author: Barath Kannan
+ * A bounded multi-producer multi-consumer ring of variable length byte records,
+ * written and read in place. A producer reserves a contiguous region for a record,
+ * writes the record into it and commits it. A consumer peeks at the next committed
+ * record, reads it in place and releases it. Records are aligned to 8 bytes and
+ * preceded by an 8 byte header holding their state and length. A record that would
+ * cross the end of the ring is placed at the start instead, and the space left at
+ * the end is filled by a padding record that consumers skip, so the largest record
+ * is half the capacity of the ring.
+ * Released space is zeroed before producers may reserve it again, so a header only
+ * reads as committed once its producer has committed it, whatever bytes were in the
+ * ring before. With several consumers, records are claimed in order, one consumer
+ * at a time, but may be released in any order, and the space of a released record
+ * is only reclaimed once every record before it has been released.
+ * The sc operations may only be used by a single consumer, and are not mixed with
+ * the mc operations. The capacity must be a power of 2 of at least 64 bytes.
+ * Created on 18 October 2026 11:50 PM
+ */
+
+#ifndef BK_CONQ_BYTERING_HPP
+#define BK_CONQ_BYTERING_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <bk_conq/layout.hpp>
+
+namespace bk_conq {
+
+template<typename LAYOUT = isolated_layout>
+class byte_ring {
+public:
+    //a committed record, valid until it is released
+    struct record {
+        const char* data;
+        size_t length;
+        uint64_t position;
+    };
+
+    byte_ring(size_t capacity) : _capacity(capacity), _mask(capacity - 1) {
+        if ((capacity < 64) || ((capacity & (~capacity + 1)) != capacity)) {
+            throw std::length_error("capacity of byte_ring must be a power of 2 of at least 64");
+        }
+        _buffer = static_cast<char*>(::operator new(capacity, std::align_val_t(alignof(record_header_t))));
+        std::memset(_buffer, 0, capacity);
+    }
+
+    ~byte_ring() {
+        ::operator delete(_buffer, std::align_val_t(alignof(record_header_t)));
+    }
+
+    byte_ring(const byte_ring&) = delete;
+    void operator=(const byte_ring&) = delete;
+
+    //the largest record length that can be reserved
+    size_t max_length() const {
+        return _capacity / 2 - sizeof(record_header_t);
+    }
+
+    //returns a region of length bytes to write the record into, or nullptr if the ring is full
+    char* sp_reserve(size_t length) {
+        const uint64_t size = record_size(length);
+        uint64_t head = _head.load(std::memory_order_relaxed);
+        uint64_t required = required_size(head, size);
+        if (head + required - _tail.load(std::memory_order_acquire) > _capacity) return nullptr;
+        _head.store(head + required, std::memory_order_relaxed);
+        return place(head, required, size, length);
+    }
+
+    char* mp_reserve(size_t length) {
+        const uint64_t size = record_size(length);
+        uint64_t head = _head.load(std::memory_order_relaxed);
+        uint64_t required;
+        do {
+            required = required_size(head, size);
+            if (head + required - _tail.load(std::memory_order_acquire) > _capacity) return nullptr;
+        } while (!_head.compare_exchange_weak(head, head + required, std::memory_order_relaxed));
+        return place(head, required, size, length);
+    }
+
+    //publishes a reserved record to consumers
+    void commit(char* data) {
+        header(data)->state.store(committed, std::memory_order_release);
+    }
+
+    //the next committed record, which stays the next record until it is released
+    bool sc_peek(record& output) {
+        while (true) {
+            uint64_t tail = _tail.load(std::memory_order_relaxed);
+            record_header_t* rec = at(tail);
+            uint32_t state = rec->state.load(std::memory_order_acquire);
+            if (state == empty) return false;
+            if (state == padding) {
+                reclaim(tail, rec);
+                continue;
+            }
+            output = record{ reinterpret_cast<const char*>(rec + 1), rec->length, tail };
+            return true;
+        }
+    }
+
+    void sc_release(const record& input) {
+        reclaim(input.position, at(input.position));
+    }
+
+    //claims the next committed record for this consumer, spin on claim contention
+    bool mc_peek(record& output) {
+        while (_claiming.exchange(true, std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        uint64_t claim = _claim.load(std::memory_order_relaxed);
+        bool found = false;
+        //a full ring wraps around to the tail record, so claims stop at the head as well as at an empty header
+        while (claim != _head.load(std::memory_order_acquire)) {
+            record_header_t* rec = at(claim);
+            uint32_t state = rec->state.load(std::memory_order_acquire);
+            if (state == empty) break;
+            uint64_t next = claim + record_size(rec->length);
+            _claim.store(next, std::memory_order_release);
+            if (state == committed) {
+                output = record{ reinterpret_cast<const char*>(rec + 1), rec->length, claim };
+                found = true;
+                break;
+            }
+            release_claimed(rec);
+            claim = next;
+        }
+        _claiming.store(false, std::memory_order_release);
+        return found;
+    }
+
+    void mc_release(const record& input) {
+        release_claimed(at(input.position));
+    }
+
+private:
+    enum record_state : uint32_t {
+        empty = 0,
+        committed = 1,
+        padding = 2,
+        released = 3
+    };
+
+    struct record_header_t {
+        std::atomic<uint32_t> state;
+        uint32_t length;
+    };
+    static_assert(sizeof(record_header_t) == 8, "record headers are 8 bytes");
+
+    static constexpr uint64_t record_size(size_t length) {
+        return (sizeof(record_header_t) + length + 7) & ~uint64_t(7);
+    }
+
+    static record_header_t* header(char* data) {
+        return reinterpret_cast<record_header_t*>(data) - 1;
+    }
+
+    record_header_t* at(uint64_t position) {
+        return reinterpret_cast<record_header_t*>(_buffer + (position & _mask));
+    }
+
+    //a record that does not fit before the end of the ring also takes the space up to the end
+    uint64_t required_size(uint64_t head, uint64_t size) {
+        if (size > _capacity / 2) throw std::length_error("byte_ring record is larger than half the capacity");
+        uint64_t to_end = _capacity - (head & _mask);
+        return size > to_end ? to_end + size : size;
+    }
+
+    char* place(uint64_t head, uint64_t required, uint64_t size, size_t length) {
+        if (required != size) {
+            record_header_t* pad = at(head);
+            pad->length = static_cast<uint32_t>(required - size - sizeof(record_header_t));
+            pad->state.store(padding, std::memory_order_release);
+            head += required - size;
+        }
+        record_header_t* rec = at(head);
+        rec->length = static_cast<uint32_t>(length);
+        return reinterpret_cast<char*>(rec + 1);
+    }
+
+    //zeroes a record at the tail and gives its space back to producers
+    void reclaim(uint64_t tail, record_header_t* rec) {
+        uint64_t size = record_size(rec->length);
+        std::memset(static_cast<void*>(rec), 0, size);
+        _tail.store(tail + size, std::memory_order_release);
+    }
+
+    //the consumer that finds the tail free reclaims every released record from it, in order
+    void release_claimed(record_header_t* rec) {
+        //sequentially consistent, so that either this thread reclaims or the reclaiming thread sees this record released
+        rec->state.store(released, std::memory_order_seq_cst);
+        while (!_reclaiming.exchange(true, std::memory_order_seq_cst)) {
+            uint64_t tail = _tail.load(std::memory_order_relaxed);
+            const uint64_t claim = _claim.load(std::memory_order_acquire);
+            for (record_header_t* next = at(tail); tail != claim && next->state.load(std::memory_order_acquire) == released; next = at(tail)) {
+                uint64_t size = record_size(next->length);
+                std::memset(static_cast<void*>(next), 0, size);
+                tail += size;
+                _tail.store(tail, std::memory_order_release);
+            }
+            _reclaiming.store(false, std::memory_order_seq_cst);
+            //a record released while the tail was being reclaimed may have been missed
+            if (tail == _claim.load(std::memory_order_seq_cst) || at(tail)->state.load(std::memory_order_seq_cst) != released) return;
+        }
+    }
+
+    const uint64_t _capacity;
+    const uint64_t _mask;
+    char* _buffer;
+    alignas(details::layout_alignment<LAYOUT, std::atomic<uint64_t>>::value) std::atomic<uint64_t> _head{ 0 };
+    alignas(details::layout_alignment<LAYOUT, std::atomic<uint64_t>>::value) std::atomic<uint64_t> _tail{ 0 };
+    alignas(details::layout_alignment<LAYOUT, std::atomic<uint64_t>>::value) std::atomic<uint64_t> _claim{ 0 };
+    std::atomic<bool> _claiming{ false };
+    std::atomic<bool> _reclaiming{ false };
+};
+
+}//namespace bk_conq
+
+#endif /* BK_CONQ_BYTERING_HPP */
@@ -7,6 +7,9 @@
 * as a linked list, where nodes are stored in a freelist after being dequeued.
 * Enqueue operations will either acquire items from the freelist or allocate a
 * new node if none are available.
+* A queue may instead be constructed with a node_pool shared with other queues of the
+* same type, in which case it takes its blocks from the pool and returns each block
+* to the pool once it is drained, rather than keeping a freelist of its own.
 * Created on 27 August 2016, 11:30 PM
 */
 
@@ -20,14 +23,19 @@
 #include <memory>
 #include <iostream>
 #include <bk_conq/unbounded_queue.hpp>
+#include <bk_conq/layout.hpp>
+#include <bk_conq/node_pool.hpp>
 
 namespace bk_conq {
 
-template<typename T>
-class chain_queue : public unbounded_queue<T, chain_queue<T>> {
-    friend unbounded_queue<T, chain_queue<T>>;
+template<typename T, typename LAYOUT = isolated_layout>
+class chain_queue : public unbounded_queue<T, chain_queue<T, LAYOUT>> {
+    friend unbounded_queue<T, chain_queue<T, LAYOUT>>;
     static const size_t BLOCK_SIZE = 1024;
+    struct list_node_t;
 public:
+    using pool_type = node_pool<list_node_t>;
+
     chain_queue() {
         auto hnode = new list_node_t;
         auto flnode = new list_node_t;
@@ -41,6 +49,20 @@ public:
         _in_progress_tail.store(_in_progress_head.load(std::memory_order_relaxed), std::memory_order_relaxed);
     }
 
+    //takes its blocks from pool and returns them to it, the freelist then only holds its dummy
+    chain_queue(std::shared_ptr<pool_type> pool) : _pool(std::move(pool)) {
+        auto hnode = pool_acquire();
+        auto flnode = new list_node_t;
+        auto ipnode = pool_acquire();
+
+        _head.store(hnode);
+        _tail.store(_head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        _free_list_head.store(flnode);
+        _free_list_tail.store(_free_list_head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        _in_progress_head.store(ipnode);
+        _in_progress_tail.store(_in_progress_head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
     virtual ~chain_queue() {
         list_node_t* next;
         list_node_t* tail = _tail.load(std::memory_order_relaxed);
@@ -48,9 +70,9 @@ public:
         for (next = tail->next.load(std::memory_order_relaxed); next != nullptr; ) {
             tail = next;
             next = next->next.load(std::memory_order_relaxed);
-            delete tail;
+            dispose(tail);
         }
-        delete _tail.load();
+        dispose(_tail.load());
 
         tail = _free_list_tail.load(std::memory_order_relaxed);
         for (next = tail->next.load(std::memory_order_relaxed); next != nullptr; ) {
@@ -64,9 +86,9 @@ public:
         for (next = tail->next.load(std::memory_order_relaxed); next != nullptr; ) {
             tail = next;
             next = next->next.load(std::memory_order_relaxed);
-            delete tail;
+            dispose(tail);
         }
-        delete _in_progress_tail.load();
+        dispose(_in_progress_tail.load());
 
     }
 
@@ -78,8 +100,9 @@ protected:
     void sp_enqueue_impl(R&& input) {
         list_node_t *node = acquire_or_allocate(std::forward<R>(input));
         if (!node) return;
-        _head.load(std::memory_order_relaxed)->next.store(node, std::memory_order_release);
-        _head.store(node, std::memory_order_relaxed);
+        //consumers push partially drained blocks back onto the head, so it is always exchanged
+        list_node_t* prev_head = _head.exchange(node, std::memory_order_acq_rel);
+        prev_head->next.store(node, std::memory_order_release);
     }
 
     template <typename R>
@@ -176,13 +199,35 @@ private:
 
 
     void freelist_enqueue(list_node_t *item) {
+        if (_pool) {
+            _pool->release(item);
+            return;
+        }
         list_enqueue(item, _free_list_head);
     }
 
     list_node_t* freelist_try_dequeue() {
+        if (_pool) return pool_acquire();
         return list_dequeue(_free_list_tail);
     }
 
+    list_node_t* pool_acquire() {
+        list_node_t* node = _pool->acquire();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        return node;
+    }
+
+    //blocks go back to the pool empty, the items left in them are dropped
+    void dispose(list_node_t* item) {
+        if (_pool) {
+            item->indx = 0;
+            _pool->release(item);
+        }
+        else {
+            delete item;
+        }
+    }
+
     void inprogress_enqueue(list_node_t *item) {
         list_enqueue(item, _in_progress_head);
     }
@@ -256,14 +301,13 @@ private:
         return nullptr;
     }
 
-    std::atomic<list_node_t*> _in_progress_head;
+    alignas(details::layout_alignment<LAYOUT, std::atomic<list_node_t*>>::value) std::atomic<list_node_t*> _in_progress_head;
     std::atomic<list_node_t*> _head;
     std::atomic<list_node_t*> _free_list_tail;
-    std::array<char, 64> _padding1;
-    std::atomic<list_node_t*> _tail;
+    alignas(details::layout_alignment<LAYOUT, std::atomic<list_node_t*>>::value) std::atomic<list_node_t*> _tail;
     std::atomic<list_node_t*> _free_list_head;
-    std::array<char, 64> _padding2;
-    std::atomic<list_node_t*> _in_progress_tail;
+    alignas(details::layout_alignment<LAYOUT, std::atomic<list_node_t*>>::value) std::atomic<list_node_t*> _in_progress_tail;
+    const std::shared_ptr<pool_type> _pool;
 };
 }//namespace bk_conq
 
@@ -0,0 +1,161 @@
+/*
+ * File:   conflating_queue.hpp
+ * Author: Barath Kannan
+ * A queue of keyed values that holds at most one pending value per key. An enqueue
+ * for a key that is already pending replaces the pending value in place, so that a
+ * consumer only ever sees the latest value of a key and never has to work through
+ * stale ones. Keys are dequeued in the order of their first pending update.
+ * Each pending value is held in its own node, and an enqueue installs its node with
+ * a single exchange, so overwriting a pending value is lock-free. Only the enqueue that
+ * finds the key with nothing pending queues the key, on an internal vector_queue with
+ * room for every key. That queue can still report full for the moment a consumer that
+ * dequeued from the same slot a lap earlier takes to release it, so the key is queued
+ * by retrying until the queue takes it, as a key left pending without being queued
+ * would never be delivered again. The node a producer replaces is
+ * kept for its next enqueue, so conflating updates do not allocate.
+ * Keys are held in an open addressed table of N keys, where N must be a power of 2,
+ * and are never removed. An enqueue fails once N distinct keys have been seen.
+ * Created on 18 October 2026 7:15 PM
+ */
+
+#ifndef BK_CONQ_CONFLATING_QUEUE_HPP
+#define BK_CONQ_CONFLATING_QUEUE_HPP
+
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <bk_conq/layout.hpp>
+#include <bk_conq/vector_queue.hpp>
+#include <bk_conq/details/tlos.hpp>
+
+namespace bk_conq {
+
+template<typename KEY, typename VALUE, typename HASH = std::hash<KEY>, typename LAYOUT = isolated_layout>
+class conflating_queue {
+public:
+    conflating_queue(size_t N) :
+        _slots(check_size(N)),
+        _mask(N - 1),
+        _order(N),
+        _spare([]() { return static_cast<VALUE*>(nullptr); }, [](VALUE*&& spare) { delete spare; })
+    {}
+
+    ~conflating_queue() {
+        for (auto& slot : _slots) {
+            delete slot.pending.load(std::memory_order_relaxed);
+        }
+    }
+
+    conflating_queue(const conflating_queue&) = delete;
+    void operator=(const conflating_queue&) = delete;
+
+    template <typename R>
+    bool sp_enqueue(const KEY& key, R&& value) {
+        return enqueue(key, std::forward<R>(value), [&](size_t indx) { while (!_order.sp_enqueue(indx)) std::this_thread::yield(); });
+    }
+
+    template <typename R>
+    bool mp_enqueue(const KEY& key, R&& value) {
+        return enqueue(key, std::forward<R>(value), [&](size_t indx) { while (!_order.mp_enqueue(indx)) std::this_thread::yield(); });
+    }
+
+    bool sc_dequeue(KEY& key, VALUE& value) {
+        return dequeue(key, value, [&](size_t& indx) { return _order.sc_dequeue(indx); });
+    }
+
+    bool mc_dequeue(KEY& key, VALUE& value) {
+        return dequeue(key, value, [&](size_t& indx) { return _order.mc_dequeue(indx); });
+    }
+
+    bool mc_dequeue_uncontended(KEY& key, VALUE& value) {
+        return dequeue(key, value, [&](size_t& indx) { return _order.mc_dequeue_uncontended(indx); });
+    }
+
+private:
+    enum : int {
+        empty,
+        inserting,
+        ready
+    };
+
+    static size_t check_size(size_t N) {
+        if ((N == 0) || ((N & (~N + 1)) != N)) {
+            throw std::length_error("size of conflating_queue must be power of 2");
+        }
+        return N;
+    }
+
+    struct alignas(details::slot_alignment<LAYOUT, KEY, std::atomic<VALUE*>>::value) slot_t {
+        std::atomic<int> state{ empty };
+        //written once, before the state is set to ready
+        KEY key;
+        std::atomic<VALUE*> pending{ nullptr };
+    };
+
+    template <typename R, typename F>
+    bool enqueue(const KEY& key, R&& value, F&& publish) {
+        size_t indx;
+        if (!find_or_insert(key, indx)) return false;
+        VALUE*& spare = _spare.get();
+        VALUE* node = spare;
+        if (node) {
+            *node = std::forward<R>(value);
+        }
+        else {
+            node = new VALUE(std::forward<R>(value));
+        }
+        //the replaced node belongs to this producer now, and becomes its spare
+        spare = _slots[indx].pending.exchange(node, std::memory_order_acq_rel);
+        if (!spare) publish(indx);
+        return true;
+    }
+
+    template <typename F>
+    bool dequeue(KEY& key, VALUE& value, F&& take) {
+        size_t indx;
+        if (!take(indx)) return false;
+        slot_t& slot = _slots[indx];
+        //a key is only queued while it has a pending value, and only the consumer that dequeued it can clear it
+        VALUE* node = slot.pending.exchange(nullptr, std::memory_order_acquire);
+        key = slot.key;
+        value = std::move(*node);
+        VALUE*& spare = _spare.get();
+        if (spare) delete node;
+        else spare = node;
+        return true;
+    }
+
+    bool find_or_insert(const KEY& key, size_t& indx) {
+        size_t hash = _hash(key);
+        for (size_t i = 0; i <= _mask; ++i) {
+            indx = (hash + i) & _mask;
+            slot_t& slot = _slots[indx];
+            int state = slot.state.load(std::memory_order_acquire);
+            if (state == empty && slot.state.compare_exchange_strong(state, inserting, std::memory_order_acquire)) {
+                slot.key = key;
+                slot.state.store(ready, std::memory_order_release);
+                return true;
+            }
+            //only the first enqueue of a key can find it being inserted
+            while (state == inserting) {
+                std::this_thread::yield();
+                state = slot.state.load(std::memory_order_acquire);
+            }
+            if (slot.key == key) return true;
+        }
+        return false;
+    }
+
+    std::vector<slot_t> _slots;
+    const size_t _mask;
+    HASH _hash;
+    vector_queue<size_t, LAYOUT> _order;
+    details::tlos<VALUE*, conflating_queue<KEY, VALUE, HASH, LAYOUT>> _spare;
+};
+
+}//namespace bk_conq
+
+#endif /* BK_CONQ_CONFLATING_QUEUE_HPP */
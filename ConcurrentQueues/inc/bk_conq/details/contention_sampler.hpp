@@ -0,0 +1,78 @@
+/*
+* File:   contention_sampler.hpp
+* Author: Barath Kannan
+* Estimates producer contention for the adaptive queues. Every sample_interval
+* enqueues, a producer checks whether another producer has sampled since it last
+* did, and records itself as the last sampler. Samples that see another producer
+* raise a shared score and samples that only see the same producer lower it, so the
+* score tracks whether several producers are enqueueing at the same time. The last
+* sampler is written when it changes and the score on every sample until it reaches
+* its bound, and as samples are only taken every sample_interval enqueues, sampling
+* adds little contention of its own. Each producer counts its enqueues separately for
+* every sampler, so producers sharing several queues sample each of them at the same
+* rate.
+* Created on 18 October 2026 4:40 PM
+*/
+
+#ifndef BK_CONQ_CONTENTIONSAMPLER_HPP
+#define BK_CONQ_CONTENTIONSAMPLER_HPP
+
+#include <atomic>
+#include <bk_conq/details/tlos.hpp>
+
+namespace bk_conq {
+namespace details {
+
+class contention_sampler {
+public:
+    enum decision {
+        none,
+        fan_out,
+        collapse
+    };
+
+    contention_sampler() : _count([]() { return size_t(0); }) {}
+
+    contention_sampler(const contention_sampler&) = delete;
+    void operator=(const contention_sampler&) = delete;
+
+    //called on every enqueue
+    decision sample() {
+        size_t& count = _count.get();
+        if ((++count & (sample_interval - 1)) != 0) return none;
+        const void* self = producer_id();
+        const void* last = _last.load(std::memory_order_relaxed);
+        if (last != self) _last.store(self, std::memory_order_relaxed);
+        long score = _score.load(std::memory_order_relaxed);
+        if (last != self && last != nullptr) {
+            if (score < max_score) score = _score.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+        else if (score > -max_score) {
+            score = _score.fetch_sub(1, std::memory_order_relaxed) - 1;
+        }
+        if (score >= threshold) return fan_out;
+        if (score <= -threshold) return collapse;
+        return none;
+    }
+
+private:
+    static constexpr size_t sample_interval = 256;
+    //the score is clamped to +/- max_score, so a switch needs at least max_score - threshold opposing samples
+    static constexpr long max_score = 16;
+    static constexpr long threshold = 8;
+
+    //the address of a thread local identifies the producer, it is the same for every sampler
+    static const void* producer_id() {
+        static thread_local char id;
+        return &id;
+    }
+
+    std::atomic<const void*> _last{ nullptr };
+    std::atomic<long> _score{ 0 };
+    tlos<size_t, contention_sampler> _count;
+};
+
+}//namespace details
+}//namespace bk_conq
+
+#endif // BK_CONQ_CONTENTIONSAMPLER_HPP
@@ -0,0 +1,33 @@
+/*
+* File:   queue_traits.hpp
+* Author: Barath Kannan
+* Recovers the element type of a queue from its bounded or unbounded interface,
+* so that adapters can accept any queue type regardless of its template parameters.
+* Created on 18 October 2026 1:34 PM
+*/
+
+#ifndef BK_CONQ_QUEUETRAITS_HPP
+#define BK_CONQ_QUEUETRAITS_HPP
+
+#include <utility>
+#include <bk_conq/bounded_queue.hpp>
+#include <bk_conq/unbounded_queue.hpp>
+
+namespace bk_conq {
+namespace details {
+
+template <typename T>
+T queue_value_type_of(const bounded_queue_typed_tag<T>*);
+
+template <typename T>
+T queue_value_type_of(const unbounded_queue_typed_tag<T>*);
+
+template <typename Q>
+struct queue_traits {
+    using value_type = decltype(queue_value_type_of(std::declval<Q*>()));
+};
+
+}//namespace details
+}//namespace bk_conq
+
+#endif // BK_CONQ_QUEUETRAITS_HPP
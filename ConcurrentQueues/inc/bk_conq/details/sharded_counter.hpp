@@ -0,0 +1,53 @@
+/*
+* File:   sharded_counter.hpp
+* Author: Barath Kannan
+* A counter split into SHARDS separately aligned atomics. Each thread adds to the
+* shard picked for it on its first add, so threads updating the counter at the same
+* time mostly write to different cache lines. Reading the counter sums the shards,
+* and gives the exact value only when no add is in progress.
+* Created on 18 October 2026 9:05 PM
+*/
+
+#ifndef BK_CONQ_SHARDEDCOUNTER_HPP
+#define BK_CONQ_SHARDEDCOUNTER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <bk_conq/layout.hpp>
+
+namespace bk_conq {
+namespace details {
+
+template <typename LAYOUT = isolated_layout, size_t SHARDS = 16>
+class sharded_counter {
+public:
+    void add(int64_t delta) {
+        _shards[local_shard()].value.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    int64_t load() const {
+        int64_t sum = 0;
+        for (auto& shard : _shards) sum += shard.value.load(std::memory_order_relaxed);
+        return sum;
+    }
+
+private:
+    struct alignas(layout_alignment<LAYOUT, std::atomic<int64_t>>::value) shard_t {
+        std::atomic<int64_t> value{ 0 };
+    };
+
+    //shards are handed out round robin to threads, shared by every counter
+    static size_t local_shard() {
+        static std::atomic<size_t> next{ 0 };
+        static thread_local size_t shard = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+        return shard;
+    }
+
+    std::array<shard_t, SHARDS> _shards;
+};
+
+}//namespace details
+}//namespace bk_conq
+
+#endif // BK_CONQ_SHARDEDCOUNTER_HPP
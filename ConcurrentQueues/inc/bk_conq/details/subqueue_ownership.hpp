@@ -0,0 +1,204 @@
+/*
+* File:   subqueue_ownership.hpp
+* Author: Barath Kannan
+* Tracks which producers are assigned to the subqueues of a multi queue, so that a
+* producer which owns its subqueue exclusively can use the single-producer enqueue.
+* A subqueue is handed out exclusively only while another unowned or shared subqueue
+* remains, so that a late producer never has to wait on an exclusive owner. When every
+* subqueue is in use, a new producer is placed on a shared subqueue and the round robin
+* target is asked to release its exclusivity. The owner acknowledges on its next enqueue
+* by switching to the shared mode, after which the waiting producer moves across on its
+* own next enqueue.
+* Where the subqueue count can grow, a new subqueue is added only when a producer
+* arrives to find no unowned or retired subqueue left, so the count never exceeds the
+* most producers active at once, and a late producer finds a subqueue of its own
+* without any being kept spare until the count reaches its capacity. Consumers retire
+* unowned subqueues they find empty, and a retired subqueue is skipped by consumers
+* until it is assigned to a producer again.
+* Each assignment advances an epoch held alongside the mode, so that a consumer can
+* never retire a subqueue that was reassigned after it was found empty.
+* Created on 18 October 2026 3:02 PM
+*/
+
+#ifndef BK_CONQ_SUBQUEUEOWNERSHIP_HPP
+#define BK_CONQ_SUBQUEUEOWNERSHIP_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace bk_conq {
+namespace details {
+
+//the subqueue assignment held thread-locally by each producer
+struct enqueue_assignment {
+    size_t indx{ 0 };
+    //subqueue to move to once its exclusive owner has acknowledged the sharing
+    size_t pending{ size_t(-1) };
+};
+
+class subqueue_ownership {
+public:
+    static constexpr size_t npos = size_t(-1);
+
+    //exclusive ownership can be disabled where other producers may enqueue to any subqueue
+    //a capacity larger than subqueues allows the subqueue count to grow up to it
+    explicit subqueue_ownership(size_t subqueues, bool allow_exclusive = true, size_t capacity = 0) :
+        _modes(new std::atomic<size_t>[capacity > subqueues ? capacity : subqueues]),
+        _producers(subqueues, 0),
+        _capacity(capacity > subqueues ? capacity : subqueues),
+        _allow_exclusive(allow_exclusive)
+    {
+        for (size_t i = 0; i < _capacity; ++i) {
+            _modes[i].store(unowned, std::memory_order_relaxed);
+        }
+    }
+
+    subqueue_ownership(const subqueue_ownership&) = delete;
+    void operator=(const subqueue_ownership&) = delete;
+
+    //called by the producer before every enqueue, returns true if it may use the single-producer path
+    bool exclusive(enqueue_assignment& assignment) {
+        if (assignment.pending != npos) try_move(assignment);
+        size_t state = _modes[assignment.indx].load(std::memory_order_relaxed);
+        if ((state & mode_mask) == exclusive_owner) return true;
+        //only the exclusive owner can observe the revoking mode, all of its single-producer
+        //enqueues are complete so the subqueue can now be shared
+        if ((state & mode_mask) == revoking) _modes[assignment.indx].store((state & ~mode_mask) | shared, std::memory_order_release);
+        return false;
+    }
+
+    //grow() must add one subqueue, it is only called while the count is below the capacity
+    template <typename GROW>
+    enqueue_assignment acquire(GROW&& grow) {
+        std::lock_guard<std::mutex> lock(_m);
+        size_t unowned_count = 0;
+        size_t shared_count = 0;
+        size_t unowned_indx = npos;
+        for (size_t i = 0; i < _producers.size(); ++i) {
+            size_t indx = (_next + i) % _producers.size();
+            if (_producers[indx] == 0 && unowned_count++ == 0) unowned_indx = indx;
+            if (mode(indx) == shared) ++shared_count;
+        }
+        //unowned and retired subqueues are reused before any is added
+        if (unowned_count == 0 && _producers.size() < _capacity) {
+            grow();
+            unowned_indx = _producers.size();
+            _producers.push_back(0);
+            ++unowned_count;
+        }
+        enqueue_assignment ret;
+        if (unowned_indx != npos) {
+            _next = unowned_indx + 1;
+            _producers[unowned_indx] = 1;
+            //keep an unowned or shared subqueue for producers that arrive once every subqueue is in use,
+            //which is only needed once no more subqueues can be added for them
+            bool exclusive = _allow_exclusive && (unowned_count > 1 || shared_count > 0 || _producers.size() < _capacity);
+            assign(unowned_indx, exclusive ? exclusive_owner : shared);
+            ret.indx = unowned_indx;
+            return ret;
+        }
+        //every subqueue is in use, share the next one in round robin order
+        size_t target = (_next++) % _producers.size();
+        ++_producers[target];
+        if (mode(target) == shared) {
+            ret.indx = target;
+            return ret;
+        }
+        if (mode(target) == exclusive_owner) set_mode(target, revoking);
+        //until the owner acknowledges, use the least used shared subqueue
+        size_t fallback = npos;
+        for (size_t i = 0; i < _producers.size(); ++i) {
+            if (mode(i) == shared && (fallback == npos || _producers[i] < _producers[fallback])) {
+                fallback = i;
+            }
+        }
+        ++_producers[fallback];
+        ret.indx = fallback;
+        ret.pending = target;
+        return ret;
+    }
+
+    void release(const enqueue_assignment& assignment) {
+        std::lock_guard<std::mutex> lock(_m);
+        size_t indx = assignment.indx;
+        size_t current = mode(indx);
+        if (--_producers[indx] == 0) {
+            set_mode(indx, unowned);
+        }
+        else if (current == exclusive_owner || current == revoking) {
+            //the owner is leaving while other producers wait on the subqueue
+            set_mode(indx, shared);
+        }
+        if (assignment.pending != npos) {
+            --_producers[assignment.pending];
+        }
+    }
+
+    //read by consumers before dequeueing from a subqueue that can be retired
+    size_t state(size_t indx) const {
+        return _modes[indx].load(std::memory_order_acquire);
+    }
+
+    static bool is_retired(size_t state) {
+        return (state & mode_mask) == retired;
+    }
+
+    //called by a consumer that found the subqueue empty after reading state
+    void try_retire(size_t indx, size_t state) {
+        if ((state & mode_mask) != unowned) return;
+        _modes[indx].compare_exchange_strong(state, (state & ~mode_mask) | retired, std::memory_order_relaxed);
+    }
+
+private:
+    enum : size_t {
+        unowned,
+        exclusive_owner,
+        revoking,
+        shared,
+        retired
+    };
+
+    //the low bits of each state hold the mode, the remaining bits count the assignments
+    static constexpr size_t mode_bits = 3;
+    static constexpr size_t mode_mask = (size_t(1) << mode_bits) - 1;
+
+    size_t mode(size_t indx) const {
+        return _modes[indx].load(std::memory_order_relaxed) & mode_mask;
+    }
+
+    //stores are released so that a consumer finding an unowned subqueue empty has seen every enqueue
+    void set_mode(size_t indx, size_t m) {
+        size_t state = _modes[indx].load(std::memory_order_relaxed);
+        _modes[indx].store((state & ~mode_mask) | m, std::memory_order_release);
+    }
+
+    void assign(size_t indx, size_t m) {
+        size_t state = _modes[indx].load(std::memory_order_relaxed);
+        _modes[indx].store((((state >> mode_bits) + 1) << mode_bits) | m, std::memory_order_release);
+    }
+
+    void try_move(enqueue_assignment& assignment) {
+        if ((_modes[assignment.pending].load(std::memory_order_acquire) & mode_mask) != shared) return;
+        std::lock_guard<std::mutex> lock(_m);
+        if (--_producers[assignment.indx] == 0) {
+            set_mode(assignment.indx, unowned);
+        }
+        assignment.indx = assignment.pending;
+        assignment.pending = npos;
+    }
+
+    //only written on ownership changes, so they are packed together
+    std::unique_ptr<std::atomic<size_t>[]> _modes;
+    std::vector<size_t> _producers;
+    const size_t _capacity;
+    size_t _next{ 0 };
+    const bool _allow_exclusive;
+    std::mutex _m;
+};
+
+}//namespace details
+}//namespace bk_conq
+
+#endif // BK_CONQ_SUBQUEUEOWNERSHIP_HPP
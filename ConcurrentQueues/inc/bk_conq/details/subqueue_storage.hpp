@@ -0,0 +1,163 @@
+/*
+* File:   subqueue_storage.hpp
+* Author: Barath Kannan
+* Contiguous storage for the subqueues of the multi queues. A COUNT of 0 selects a
+* count chosen at runtime, with the subqueues constructed in a single aligned heap
+* allocation. Any other COUNT holds the subqueues inline in a std::array, so that
+* the count is a compile time constant and no allocation is made for the array.
+* A COUNT of dynamic_subqueues reserves contiguous space for a maximum count but
+* constructs no subqueue up front. Subqueues are constructed in place by grow() on the
+* calling thread, so their memory is first touched by the thread that will use them,
+* and the pages reserved for subqueues that are never constructed are never touched.
+* Subqueues are never removed while the storage exists, so a consumer may keep using
+* any index below size().
+* The construction arguments are passed to every subqueue.
+* Created on 18 October 2026 1:41 PM
+*/
+
+#ifndef BK_CONQ_SUBQUEUESTORAGE_HPP
+#define BK_CONQ_SUBQUEUESTORAGE_HPP
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace bk_conq {
+namespace details {
+
+constexpr size_t dynamic_subqueues = size_t(-1);
+
+template <typename Q, size_t COUNT>
+class subqueue_storage {
+public:
+    template <typename... Args>
+    subqueue_storage(const Args&... args) : subqueue_storage(std::make_index_sequence<COUNT>(), args...) {}
+
+    subqueue_storage(const subqueue_storage&) = delete;
+    void operator=(const subqueue_storage&) = delete;
+
+    Q& operator[](size_t indx) {
+        return _q[indx];
+    }
+
+    static constexpr size_t size() {
+        return COUNT;
+    }
+
+private:
+    template <size_t... I, typename... Args>
+    subqueue_storage(std::index_sequence<I...>, const Args&... args) : _q{ { construct<I>(args...)... } } {}
+
+    //subqueues are neither copyable nor movable, the returned prvalue initializes the element directly
+    template <size_t I, typename... Args>
+    static Q construct(const Args&... args) {
+        return Q(args...);
+    }
+
+    std::array<Q, COUNT> _q;
+};
+
+template <typename Q>
+class subqueue_storage<Q, 0> {
+public:
+    template <typename... Args>
+    subqueue_storage(size_t count, const Args&... args) :
+        _q(static_cast<Q*>(::operator new(sizeof(Q) * count, std::align_val_t(alignof(Q))))),
+        _size(0)
+    {
+        try {
+            for (; _size < count; ++_size) {
+                new (&_q[_size]) Q(args...);
+            }
+        }
+        catch (...) {
+            destroy();
+            throw;
+        }
+    }
+
+    ~subqueue_storage() {
+        destroy();
+    }
+
+    subqueue_storage(const subqueue_storage&) = delete;
+    void operator=(const subqueue_storage&) = delete;
+
+    Q& operator[](size_t indx) {
+        return _q[indx];
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+private:
+    void destroy() {
+        while (_size) {
+            _q[--_size].~Q();
+        }
+        ::operator delete(_q, std::align_val_t(alignof(Q)));
+    }
+
+    Q* const _q;
+    size_t _size;
+};
+
+template <typename Q>
+class subqueue_storage<Q, dynamic_subqueues> {
+public:
+    template <typename... Args>
+    subqueue_storage(size_t capacity, const Args&... args) :
+        _q(static_cast<Q*>(::operator new(sizeof(Q) * capacity, std::align_val_t(alignof(Q))))),
+        _capacity(capacity),
+        _construct([args...](void* where) { new (where) Q(args...); })
+    {
+        if (capacity == 0) {
+            ::operator delete(_q, std::align_val_t(alignof(Q)));
+            throw std::length_error("subqueue capacity must be at least 1");
+        }
+    }
+
+    ~subqueue_storage() {
+        for (size_t i = _size.load(std::memory_order_relaxed); i > 0; --i) {
+            _q[i - 1].~Q();
+        }
+        ::operator delete(_q, std::align_val_t(alignof(Q)));
+    }
+
+    subqueue_storage(const subqueue_storage&) = delete;
+    void operator=(const subqueue_storage&) = delete;
+
+    Q& operator[](size_t indx) {
+        return _q[indx];
+    }
+
+    size_t size() const {
+        return _size.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const {
+        return _capacity;
+    }
+
+    //constructs the next subqueue in place on the calling thread, callers must serialize calls and stay within the capacity
+    void grow() {
+        size_t indx = _size.load(std::memory_order_relaxed);
+        _construct(&_q[indx]);
+        _size.store(indx + 1, std::memory_order_release);
+    }
+
+private:
+    Q* const _q;
+    const size_t _capacity;
+    std::function<void(void*)> _construct;
+    std::atomic<size_t> _size{ 0 };
+};
+
+}//namespace details
+}//namespace bk_conq
+
+#endif // BK_CONQ_SUBQUEUESTORAGE_HPP
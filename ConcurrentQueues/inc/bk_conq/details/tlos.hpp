@@ -13,6 +13,7 @@
 #include <set>
 #include <atomic>
 #include <thread>
+#include <functional>
 
 namespace bk_conq {
 namespace details {
@@ -30,16 +31,16 @@ public:
         std::lock_guard<std::mutex> lock(_m);
         size_t myindx;
         //check if a previous owner returned their index
-        if (!_available.empty()) {
+        if (!available().empty()) {
             //use that index if available
-            myindx = _available.back();
-            _owners[myindx] = myid;
-            _available.pop_back();
+            myindx = available().back();
+            owners()[myindx] = myid;
+            available().pop_back();
         }
         else {
             //otherwise generate a new one
-            myindx = _owners.size();
-            _owners.push_back(myid);
+            myindx = owners().size();
+            owners().push_back(myid);
         }
         return myindx;
     }
@@ -47,7 +48,7 @@ public:
     virtual ~tlos() {
         std::lock_guard<std::mutex> lock(_m);
         //invoke the returner for all thread local boxes corresponding to this index
-        for (returner* ret : _thread_locals) {
+        for (returner* ret : thread_locals()) {
             std::vector<box>& vec = (*ret)();
             //if the size is not greater than the index, the thread-local object was never accessed
             //and hence it was never initialized
@@ -62,13 +63,13 @@ public:
             }
         }
         //relinquish the index and mark it as available for others
-        _available.push_back(_myindx);
+        available().push_back(_myindx);
         //mark the index as unused
-        _owners[_myindx] = 0;
+        owners()[_myindx] = 0;
         //if this is the last tlos instance of this type, clear some of the static space
-        if (_available.size() == _owners.size()) {
-            _available.clear();
-            _owners.clear();
+        if (available().size() == owners().size()) {
+            available().clear();
+            owners().clear();
         }
     }
 
@@ -129,7 +130,7 @@ private:
     public:
         returner() {
             std::lock_guard<std::mutex> lock(_m);
-            _thread_locals.insert(this);
+            thread_locals().insert(this);
         }
 
         std::vector<box>& get() {
@@ -146,15 +147,15 @@ private:
         ~returner() {
             std::lock_guard<std::mutex> lock(_m);
             //owners size will only be less if it was flushed by a tlos dtor
-            for (size_t i = 0; i < _v.size() && i < _owners.size(); ++i) {
+            for (size_t i = 0; i < _v.size() && i < owners().size(); ++i) {
                 auto& current_id = _v.at(i);
                 //check if a returnfunc has been defined, and
                 //check if the object who owns the item is still valid
-                if (current_id.returnfunc && current_id.owner_id && _owners[i] == current_id.owner_id) {
+                if (current_id.returnfunc && current_id.owner_id && owners()[i] == current_id.owner_id) {
                     current_id.returnfunc(std::move(current_id.value));
                 }
             }
-            _thread_locals.erase(this);
+            thread_locals().erase(this);
         }
     };
 
@@ -170,23 +171,36 @@ private:
     //defines a function to notify the owning object that a thread owning a thread-local instance has gone out of scope
     const std::function<void(T&&)> _returnfunc{ nullptr };
 
-    //identifies the index of this objects U item in the thread
-    const size_t _myindx;
-
     //uniquely identifies this object (prefer using this to pointer as another object of the same type can be given the same address)
+    //declared ahead of _myindx, which is initialized from it
     const size_t _myid;
 
+    //identifies the index of this objects U item in the thread
+    const size_t _myindx;
+
     //counter for assigning the objects unique id, starting at 1
     static std::atomic<size_t> _id;
 
+    //the shared containers are function local statics so that a tlos can be constructed
+    //during static initialization, as happens for a multi queue with static storage duration
+
     //vector of released box indexes
-    static std::vector<size_t> _available;
+    static std::vector<size_t>& available() {
+        static std::vector<size_t> v;
+        return v;
+    }
 
     //maps box indexes to their owners id
-    static std::vector<size_t> _owners;
+    static std::vector<size_t>& owners() {
+        static std::vector<size_t> v;
+        return v;
+    }
 
     //provides global access to the thread local vectors
-    static std::set<returner*> _thread_locals;
+    static std::set<returner*>& thread_locals() {
+        static std::set<returner*> s;
+        return s;
+    }
 
     static std::mutex _m;
 };
@@ -194,15 +208,6 @@ private:
 template <typename T, typename OWNER>
 std::atomic<size_t> tlos<T, OWNER>::_id(1);
 
-template <typename T, typename OWNER>
-std::vector<size_t> tlos<T, OWNER>::_available;
-
-template <typename T, typename OWNER>
-std::vector<size_t> tlos<T, OWNER>::_owners;
-
-template <typename T, typename OWNER>
-std::set<typename tlos<T, OWNER>::returner*> tlos<T, OWNER>::_thread_locals;
-
 template <typename T, typename OWNER>
 std::mutex tlos<T, OWNER>::_m;
 
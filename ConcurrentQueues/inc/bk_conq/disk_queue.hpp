@@ -0,0 +1,315 @@
+/*
+ * File:   disk_queue.hpp
+ * Author: Barath Kannan
+ * An unbounded multi-producer multi-consumer queue that holds at most three chunks of
+ * items in memory and stores the rest in segment files in a directory. Producers
+ * append to a write chunk. When the write chunk is full it becomes the read chunk if
+ * consumers have run out of items, and is otherwise handed to a writer thread owned by
+ * the queue, which writes it out as a new segment file through a shared mapping, in
+ * one sequential copy. One chunk is in flight at a time, so a producer that fills the
+ * write chunk only waits while the writer is still writing the previous one. Consumers
+ * take items from the read chunk, and when it runs out they map the oldest segment
+ * file back into the read chunk and remove the file, or take the write chunk if no
+ * segment is left. A consumer reads a segment without holding the queue, so producers
+ * carry on meanwhile, while other consumers wait for it, and a consumer that reaches
+ * the chunk in flight waits for it to be written. Items are therefore dequeued in the
+ * order they were enqueued.
+ * Every other operation takes a mutex, the queue is intended as the overflow of a
+ * faster queue (see spill_queue) rather than as a queue on its own. T must be trivially
+ * copyable, as items are stored as their bytes. Failures to read a segment file are
+ * thrown as std::system_error by the dequeue, and a failure of the writer is thrown
+ * by the next enqueue that fills the write chunk, the chunk that failed being kept in
+ * memory in its place. The segment files left when the queue is destroyed are removed.
+ * Created on 18 October 2026 10:20 PM
+ */
+
+#ifndef BK_CONQ_DISKQUEUE_HPP
+#define BK_CONQ_DISKQUEUE_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <bk_conq/unbounded_queue.hpp>
+
+namespace bk_conq {
+
+template<typename T>
+class disk_queue : public unbounded_queue<T, disk_queue<T>> {
+    friend unbounded_queue<T, disk_queue<T>>;
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable to be written to a segment file");
+public:
+    //segment files are created in directory, chunk_items is the item count of each chunk and segment
+    disk_queue(const std::string& directory, size_t chunk_items = 65536) :
+        _prefix(directory + "/bk_conq_spill_" + std::to_string(::getpid()) + "_" + std::to_string(next_queue_id()) + "_"),
+        _chunk_items(check_chunk_items(chunk_items)),
+        _writer([this]() { write_loop(); })
+    {
+        _write_chunk.reserve(_chunk_items);
+    }
+
+    ~disk_queue() {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _stop = true;
+        }
+        _changed.notify_all();
+        _writer.join();
+        for (auto& segment : _segments) {
+            if (segment.unwritten.empty()) ::unlink(segment_path(segment.id).c_str());
+        }
+    }
+
+    disk_queue(const disk_queue&) = delete;
+    void operator=(const disk_queue&) = delete;
+
+    //number of segment files written and not yet read back
+    size_t segments_on_disk() const {
+        return _segments_on_disk.load(std::memory_order_relaxed);
+    }
+
+protected:
+    template <typename R>
+    void sp_enqueue_impl(R&& input) {
+        mp_enqueue_impl(std::forward<R>(input));
+    }
+
+    template <typename R>
+    void mp_enqueue_impl(R&& input) {
+        std::unique_lock<std::mutex> lock(_lock);
+        if (_write_chunk.size() == _chunk_items) seal_write_chunk(lock);
+        _write_chunk.push_back(std::forward<R>(input));
+    }
+
+    bool sc_dequeue_impl(T& output) {
+        return mc_dequeue_impl(output);
+    }
+
+    bool mc_dequeue_impl(T& output) {
+        std::unique_lock<std::mutex> lock(_lock);
+        return locked_dequeue(lock, output, true);
+    }
+
+    //fails rather than waiting for another consumer or the writer
+    bool mc_dequeue_uncontended_impl(T& output) {
+        std::unique_lock<std::mutex> lock(_lock, std::try_to_lock);
+        return lock.owns_lock() && locked_dequeue(lock, output, false);
+    }
+
+private:
+    struct segment_t {
+        size_t id;
+        size_t count;
+        //the items of a segment that could not be written, which stay in memory
+        std::vector<T> unwritten;
+    };
+
+    static size_t next_queue_id() {
+        static std::atomic<size_t> id{ 0 };
+        return id.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static size_t check_chunk_items(size_t chunk_items) {
+        if (chunk_items == 0) {
+            throw std::length_error("chunk_items of disk_queue must be at least 1");
+        }
+        return chunk_items;
+    }
+
+    std::string segment_path(size_t id) const {
+        return _prefix + std::to_string(id) + ".seg";
+    }
+
+    //items are read from the read chunk, then the segments, then the chunk in flight, then the write chunk
+    bool locked_dequeue(std::unique_lock<std::mutex>& lock, T& output, bool wait) {
+        while (_read_next == _read_chunk.size()) {
+            if (_loading || (_segments.empty() && _flushing_busy)) {
+                if (!wait) return false;
+                _changed.wait(lock);
+                continue;
+            }
+            _read_chunk.clear();
+            _read_next = 0;
+            if (!_segments.empty()) {
+                load_segment(lock);
+            }
+            else if (!_write_chunk.empty()) {
+                std::swap(_read_chunk, _write_chunk);
+                _write_chunk.reserve(_chunk_items);
+            }
+            else {
+                return false;
+            }
+        }
+        output = _read_chunk[_read_next++];
+        return true;
+    }
+
+    //a full write chunk skips the disk when consumers have nothing older to read
+    //another producer may have sealed the write chunk while this one waited for the writer, so fullness is checked again
+    void seal_write_chunk(std::unique_lock<std::mutex>& lock) {
+        while (_write_chunk.size() == _chunk_items) {
+            if (_segments.empty() && !_flushing_busy && !_loading && _read_next == _read_chunk.size()) {
+                _read_chunk.clear();
+                _read_next = 0;
+                std::swap(_read_chunk, _write_chunk);
+            }
+            else if (_flushing_busy) {
+                _changed.wait(lock);
+            }
+            else if (_write_error) {
+                std::exception_ptr error = _write_error;
+                _write_error = nullptr;
+                std::rethrow_exception(error);
+            }
+            else {
+                std::swap(_flushing, _write_chunk);
+                _write_chunk.clear();
+                _write_chunk.reserve(_chunk_items);
+                _flushing_busy = true;
+                _changed.notify_all();
+            }
+        }
+    }
+
+    //writes each chunk handed over by a producer, the chunk in flight is only touched by this thread while busy
+    void write_loop() {
+        std::unique_lock<std::mutex> lock(_lock);
+        while (true) {
+            _changed.wait(lock, [this]() { return _flushing_busy || _stop; });
+            if (!_flushing_busy) return;
+            segment_t segment{ _next_segment_id++, _flushing.size(), {} };
+            lock.unlock();
+            std::exception_ptr error;
+            try {
+                write_segment(segment);
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+            lock.lock();
+            if (error) {
+                _write_error = error;
+                segment.unwritten = std::move(_flushing);
+                _flushing = std::vector<T>();
+            }
+            _flushing.clear();
+            _segments.push_back(std::move(segment));
+            _flushing_busy = false;
+            update_segments_on_disk();
+            _changed.notify_all();
+        }
+    }
+
+    void write_segment(const segment_t& segment) {
+        std::string path = segment_path(segment.id);
+        size_t bytes = segment.count * sizeof(T);
+        int fd = ::open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "open " + path);
+        if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            int err = errno;
+            ::close(fd);
+            ::unlink(path.c_str());
+            throw std::system_error(err, std::generic_category(), "ftruncate " + path);
+        }
+        void* region = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        int err = errno;
+        ::close(fd);
+        if (region == MAP_FAILED) {
+            ::unlink(path.c_str());
+            throw std::system_error(err, std::generic_category(), "mmap " + path);
+        }
+        std::memcpy(region, _flushing.data(), bytes);
+        ::munmap(region, bytes);
+    }
+
+    //reads the oldest segment into the read chunk without holding the lock, other consumers wait for it
+    void load_segment(std::unique_lock<std::mutex>& lock) {
+        segment_t segment = std::move(_segments.front());
+        _segments.pop_front();
+        update_segments_on_disk();
+        if (!segment.unwritten.empty()) {
+            std::swap(_read_chunk, segment.unwritten);
+            return;
+        }
+        std::vector<T> chunk;
+        std::swap(chunk, _read_chunk);
+        _loading = true;
+        lock.unlock();
+        std::exception_ptr error;
+        try {
+            read_segment(segment, chunk);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        lock.lock();
+        _loading = false;
+        _changed.notify_all();
+        if (error) {
+            _segments.push_front(std::move(segment));
+            update_segments_on_disk();
+            std::rethrow_exception(error);
+        }
+        std::swap(_read_chunk, chunk);
+    }
+
+    void read_segment(const segment_t& segment, std::vector<T>& chunk) {
+        std::string path = segment_path(segment.id);
+        size_t bytes = segment.count * sizeof(T);
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "open " + path);
+        void* region = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        int err = errno;
+        ::close(fd);
+        if (region == MAP_FAILED) throw std::system_error(err, std::generic_category(), "mmap " + path);
+        ::madvise(region, bytes, MADV_SEQUENTIAL);
+        chunk.resize(segment.count);
+        std::memcpy(chunk.data(), region, bytes);
+        ::munmap(region, bytes);
+        ::unlink(path.c_str());
+    }
+
+    void update_segments_on_disk() {
+        size_t on_disk = 0;
+        for (auto& segment : _segments) {
+            if (segment.unwritten.empty()) ++on_disk;
+        }
+        _segments_on_disk.store(on_disk, std::memory_order_relaxed);
+    }
+
+    const std::string _prefix;
+    const size_t _chunk_items;
+    std::mutex _lock;
+    //signalled when the chunk in flight is handed over or written, a segment is loaded, or the queue stops
+    std::condition_variable _changed;
+    std::vector<T> _write_chunk;
+    std::vector<T> _read_chunk;
+    size_t _read_next{ 0 };
+    std::vector<T> _flushing;
+    bool _flushing_busy{ false };
+    bool _loading{ false };
+    bool _stop{ false };
+    std::exception_ptr _write_error;
+    std::deque<segment_t> _segments;
+    size_t _next_segment_id{ 0 };
+    std::atomic<size_t> _segments_on_disk{ 0 };
+    //started last, once the members it uses are constructed
+    std::thread _writer;
+};
+
+}//namespace bk_conq
+
+#endif /* BK_CONQ_DISKQUEUE_HPP */
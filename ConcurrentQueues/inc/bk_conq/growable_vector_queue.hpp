@@ -0,0 +1,191 @@
+/*
+ * File:   growable_vector_queue.hpp
+ * Author: Barath Kannan
+ * This is a bounded multi-producer multi-consumer queue which starts with a small
+ * ring and grows it online up to a maximum size. Each ring is a Vyukov bounded
+ * queue, so the steady state fast path is the same as the vector queue. When a
+ * producer observes the current ring to be full and the maximum size has not been
+ * reached, it closes the ring by marking its head sequence and links a ring of
+ * twice the size behind it. Producers move on to the new ring while consumers
+ * drain the closed ring before following the link, so consumers are never stopped
+ * and the order of each producer's items is preserved. Drained rings are retained
+ * until the queue is destroyed, so the memory held is at most twice that of the
+ * largest ring. Both sizes must be powers of 2 and at least 2.
+ * Created on 18 October 2026, 11:05 AM
+ */
+
+#ifndef BK_CONQ_GROWABLEVECTORQUEUE_HPP
+#define BK_CONQ_GROWABLEVECTORQUEUE_HPP
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+#include <bk_conq/bounded_queue.hpp>
+#include <bk_conq/layout.hpp>
+
+namespace bk_conq {
+template<typename T, typename LAYOUT = isolated_layout>
+class growable_vector_queue : public bounded_queue<T, growable_vector_queue<T, LAYOUT>> {
+    friend bounded_queue<T, growable_vector_queue<T, LAYOUT>>;
+public:
+    growable_vector_queue(size_t initial_size, size_t max_size) : _max_size(max_size) {
+        if (initial_size < 2 || !is_power_of_2(initial_size) || !is_power_of_2(max_size) || initial_size > max_size) {
+            throw std::length_error("sizes of growable_vector_queue must be powers of 2, at least 2, and initial_size must not exceed max_size");
+        }
+        _first_ring = new ring_t(initial_size);
+        _head_ring.store(_first_ring, std::memory_order_relaxed);
+        _tail_ring.store(_first_ring, std::memory_order_relaxed);
+    }
+
+    virtual ~growable_vector_queue() {
+        for (ring_t* ring = _first_ring; ring != nullptr; ) {
+            ring_t* next = ring->next.load(std::memory_order_relaxed);
+            delete ring;
+            ring = next;
+        }
+    }
+
+    growable_vector_queue(const growable_vector_queue&) = delete;
+    void operator=(const growable_vector_queue&) = delete;
+
+    //size of the ring currently accepting enqueues
+    size_t capacity() const {
+        return _head_ring.load(std::memory_order_acquire)->sm1 + 1;
+    }
+
+protected:
+    template <typename R>
+    bool sp_enqueue_impl(R&& input) {
+        return mp_enqueue_impl(std::forward<R>(input));
+    }
+
+    template <typename R>
+    bool mp_enqueue_impl(R&& input) {
+        while (true) {
+            ring_t* ring = _head_ring.load(std::memory_order_acquire);
+            size_t head_seq = ring->head_seq.load(std::memory_order_relaxed);
+            if (head_seq & closed_bit) {
+                advance_head(ring);
+                continue;
+            }
+            node_t& node = ring->buffer[head_seq & ring->sm1];
+            size_t node_seq = node.seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)node_seq - (intptr_t)head_seq;
+            if (dif == 0) {
+                if (ring->head_seq.compare_exchange_weak(head_seq, head_seq + 1, std::memory_order_relaxed)) {
+                    node.data = std::forward<R>(input);
+                    node.seq.store(head_seq + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (dif < 0 && !try_grow(ring, head_seq)) {
+                return false;
+            }
+        }
+    }
+
+    bool sc_dequeue_impl(T& data) {
+        return mc_dequeue_impl(data);
+    }
+
+    bool mc_dequeue_impl(T& data) {
+        while (true) {
+            ring_t* ring = _tail_ring.load(std::memory_order_acquire);
+            size_t tail_seq = ring->tail_seq.load(std::memory_order_relaxed);
+            node_t& node = ring->buffer[tail_seq & ring->sm1];
+            size_t node_seq = node.seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)node_seq - (intptr_t)(tail_seq + 1);
+            if (dif == 0) {
+                if (ring->tail_seq.compare_exchange_weak(tail_seq, tail_seq + 1, std::memory_order_relaxed)) {
+                    data = std::move(node.data);
+                    node.seq.store(tail_seq + ring->sm1 + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (dif < 0 && !try_advance_tail(ring, tail_seq)) {
+                return false;
+            }
+        }
+    }
+
+    bool mc_dequeue_uncontended_impl(T& data) {
+        return mc_dequeue_impl(data);
+    }
+
+private:
+    struct alignas(details::slot_alignment<LAYOUT, T, std::atomic<size_t>>::value) node_t {
+        T                     data;
+        std::atomic<size_t>   seq;
+    };
+
+    struct ring_t {
+        ring_t(size_t N) : buffer(N), sm1(N - 1) {
+            for (size_t i = 0; i < N; ++i) {
+                buffer[i].seq.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        std::vector<node_t> buffer;
+        const size_t sm1;
+        std::atomic<ring_t*> next{ nullptr };
+        alignas(details::layout_alignment<LAYOUT, std::atomic<size_t>>::value) std::atomic<size_t> head_seq{ 0 };
+        alignas(details::layout_alignment<LAYOUT, std::atomic<size_t>>::value) std::atomic<size_t> tail_seq{ 0 };
+    };
+
+    //set on a ring's head sequence once producers must move on to the next ring
+    static constexpr size_t closed_bit = size_t(1) << (sizeof(size_t) * 8 - 1);
+
+    static bool is_power_of_2(size_t N) {
+        return (N != 0) && ((N & (~N + 1)) == N);
+    }
+
+    //called by a producer that found the ring full, returns false if the enqueue should fail
+    bool try_grow(ring_t* ring, size_t head_seq) {
+        if (ring->sm1 + 1 >= _max_size) return false;
+        //only one producer can close the ring, the others retry and follow the link
+        if (!ring->head_seq.compare_exchange_strong(head_seq, head_seq | closed_bit, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            return true;
+        }
+        ring_t* next;
+        try {
+            next = new ring_t((ring->sm1 + 1) * 2);
+        }
+        catch (...) {
+            //nothing else writes the head sequence of a closed ring, so it can be reopened
+            ring->head_seq.store(head_seq, std::memory_order_release);
+            throw;
+        }
+        ring->next.store(next, std::memory_order_release);
+        _head_ring.compare_exchange_strong(ring, next, std::memory_order_acq_rel);
+        return true;
+    }
+
+    void advance_head(ring_t* ring) {
+        ring_t* next = ring->next.load(std::memory_order_acquire);
+        if (!next) {
+            //the closing producer is still allocating the next ring
+            std::this_thread::yield();
+            return;
+        }
+        _head_ring.compare_exchange_strong(ring, next, std::memory_order_acq_rel);
+    }
+
+    //called by a consumer that found the ring empty, returns false if the dequeue should fail
+    bool try_advance_tail(ring_t* ring, size_t tail_seq) {
+        //a ring can only be left once it is closed and every slot claimed before closing has been consumed
+        if (ring->head_seq.load(std::memory_order_acquire) != (tail_seq | closed_bit)) return false;
+        ring_t* next = ring->next.load(std::memory_order_acquire);
+        if (!next) return false;
+        _tail_ring.compare_exchange_strong(ring, next, std::memory_order_acq_rel);
+        return true;
+    }
+
+    const size_t _max_size;
+    ring_t* _first_ring;
+    alignas(details::layout_alignment<LAYOUT, std::atomic<ring_t*>>::value) std::atomic<ring_t*> _head_ring;
+    alignas(details::layout_alignment<LAYOUT, std::atomic<ring_t*>>::value) std::atomic<ring_t*> _tail_ring;
+};
+} //namespace bk_conq
+
+#endif /* BK_CONQ_GROWABLEVECTORQUEUE_HPP */
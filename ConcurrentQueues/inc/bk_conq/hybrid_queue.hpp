@@ -0,0 +1,137 @@
+/*
+ * File:   hybrid_queue.hpp
+ * Author: Barath Kannan
+ * An unbounded queue made of a bounded ring Q and an unbounded overflow queue
+ * OVERFLOW_Q. Enqueues go to the ring, and only once the ring is full do they go to the
+ * overflow, which then takes every enqueue until consumers have emptied it. Consumers
+ * try the ring before the overflow, so items that went to the overflow generally
+ * follow the ring items enqueued before them. This does not hold for every item, as
+ * a consumer moves on to the overflow whenever its ring dequeue fails, which includes
+ * finding the slot at the tail of the ring still being written by a producer. Items
+ * in the ring behind that slot, including those of a producer whose later items went
+ * to the overflow, are then dequeued after those later items. Each producer's items
+ * keep their order when the consumers only run once the producers have stopped, or
+ * when the ring never fills.
+ * In the steady state neither side touches the overflow: producers read a state word
+ * that is only written while the overflow is in use, and consumers only look at the
+ * overflow when that word marks it as active. The state word also counts the overflow
+ * enqueues started and in progress, so that a consumer only marks the overflow as
+ * inactive if no enqueue to it has started since the consumer found it empty.
+ * Created on 18 October 2026 8:30 PM
+ */
+
+#ifndef BK_CONQ_HYBRID_QUEUE_HPP
+#define BK_CONQ_HYBRID_QUEUE_HPP
+
+#include <atomic>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <bk_conq/bounded_queue.hpp>
+#include <bk_conq/unbounded_queue.hpp>
+#include <bk_conq/layout.hpp>
+#include <bk_conq/details/queue_traits.hpp>
+
+namespace bk_conq {
+
+template<typename Q, typename OVERFLOW_Q, typename LAYOUT = isolated_layout>
+class hybrid_queue : public unbounded_queue<typename details::queue_traits<Q>::value_type, hybrid_queue<Q, OVERFLOW_Q, LAYOUT>> {
+    using T = typename details::queue_traits<Q>::value_type;
+    friend unbounded_queue<T, hybrid_queue<Q, OVERFLOW_Q, LAYOUT>>;
+    static_assert(std::is_base_of<bk_conq::bounded_queue_tag, Q>::value, "Q must be a bounded queue");
+    static_assert(std::is_base_of<bk_conq::unbounded_queue_typed_tag<T>, OVERFLOW_Q>::value, "OVERFLOW_Q must be an unbounded queue of the same type as Q");
+public:
+    //the arguments are passed to the ring
+    template <typename... Args>
+    hybrid_queue(const Args&... args) : _ring(args...) {}
+
+    //the arguments in the first tuple are passed to the ring and those in the second to the overflow
+    template <typename... RingArgs, typename... OverflowArgs>
+    hybrid_queue(std::piecewise_construct_t, const std::tuple<RingArgs...>& ring_args, const std::tuple<OverflowArgs...>& overflow_args) :
+        _ring(std::make_from_tuple<Q>(ring_args)),
+        _overflow(std::make_from_tuple<OVERFLOW_Q>(overflow_args))
+    {}
+
+    hybrid_queue(const hybrid_queue&) = delete;
+    void operator=(const hybrid_queue&) = delete;
+
+    //true while enqueues go to the overflow
+    bool overflowing() const {
+        return _state.load(std::memory_order_relaxed) & active_bit;
+    }
+
+protected:
+    const OVERFLOW_Q& overflow() const {
+        return _overflow;
+    }
+
+    template <typename R>
+    void sp_enqueue_impl(R&& input) {
+        if (!(_state.load(std::memory_order_relaxed) & active_bit) && _ring.sp_enqueue(std::forward<R>(input))) return;
+        overflow_enqueue([&]() { _overflow.sp_enqueue(std::forward<R>(input)); });
+    }
+
+    template <typename R>
+    void mp_enqueue_impl(R&& input) {
+        if (!(_state.load(std::memory_order_relaxed) & active_bit) && _ring.mp_enqueue(std::forward<R>(input))) return;
+        overflow_enqueue([&]() { _overflow.mp_enqueue(std::forward<R>(input)); });
+    }
+
+    bool sc_dequeue_impl(T& output) {
+        if (_ring.sc_dequeue(output)) return true;
+        return overflow_dequeue([&]() { return _overflow.sc_dequeue(output); });
+    }
+
+    bool mc_dequeue_impl(T& output) {
+        if (_ring.mc_dequeue(output)) return true;
+        return overflow_dequeue([&]() { return _overflow.mc_dequeue(output); });
+    }
+
+    bool mc_dequeue_uncontended_impl(T& output) {
+        if (_ring.mc_dequeue_uncontended(output)) return true;
+        return overflow_dequeue([&]() { return _overflow.mc_dequeue_uncontended(output); });
+    }
+
+private:
+    //the state word holds the active bit, the overflow enqueues in progress, and the overflow enqueues started
+    static constexpr size_t active_bit = 1;
+    static constexpr size_t in_progress_unit = size_t(1) << 1;
+    static constexpr size_t in_progress_mask = ((size_t(1) << 16) - 1) << 1;
+    static constexpr size_t started_unit = size_t(1) << 17;
+
+    template <typename F>
+    void overflow_enqueue(F&& enqueue) {
+        size_t state = _state.load(std::memory_order_relaxed);
+        while (!_state.compare_exchange_weak(state, (state + started_unit + in_progress_unit) | active_bit, std::memory_order_relaxed));
+        in_progress_guard guard{ _state };
+        enqueue();
+    }
+
+    //a consumer that sees no enqueue in progress has seen this one complete, or fail with an exception
+    struct in_progress_guard {
+        std::atomic<size_t>& state;
+        ~in_progress_guard() {
+            state.fetch_sub(in_progress_unit, std::memory_order_release);
+        }
+    };
+
+    template <typename F>
+    bool overflow_dequeue(F&& dequeue) {
+        size_t state = _state.load(std::memory_order_acquire);
+        if (!(state & active_bit)) return false;
+        if (dequeue()) return true;
+        //the overflow was empty, unless an enqueue to it was in progress or has started since
+        if ((state & in_progress_mask) == 0) {
+            _state.compare_exchange_strong(state, state & ~active_bit, std::memory_order_relaxed);
+        }
+        return false;
+    }
+
+    Q _ring;
+    OVERFLOW_Q _overflow;
+    alignas(details::layout_alignment<LAYOUT, std::atomic<size_t>>::value) std::atomic<size_t> _state{ 0 };
+};
+
+}//namespace bk_conq
+
+#endif /* BK_CONQ_HYBRID_QUEUE_HPP */
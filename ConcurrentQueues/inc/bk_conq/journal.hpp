@@ -0,0 +1,338 @@
+/*
+ * File:   journal.hpp
+ * Author: Barath Kannan
+ * A durable append-only journal of byte records, shared between the threads and
+ * processes of one host through memory mapped files in a directory. The journal is a
+ * sequence of numbered files of a fixed size, each holding a header and a run of
+ * length prefixed records aligned to 8 bytes.
+ * A journal_appender reserves space for a record by adding its size to the write
+ * position in the file header, copies the record in, and then publishes it by storing
+ * the record state with release ordering, in the same way as vector_queue publishes a
+ * slot through its sequence. The appender whose reservation crosses the end of a file
+ * marks the file as rolled, and every appender then moves on to the next file, which
+ * is created under a temporary name and linked into place once initialized, so other
+ * processes only ever map a complete file.
+ * A journal_tailer reads the records in order from its own position, loading each
+ * record state with acquire ordering, and following roll marks to the next file. The
+ * position of a tailer can be saved and passed to a new tailer to restart from it.
+ * Records of different appenders are ordered by their reservations, and a record that
+ * is reserved but not yet published holds back the tailers until it is.
+ * Files are never removed by the journal, so it can be replayed from the start. Records
+ * are in the page cache once published, sync() writes the current file to storage.
+ * Each appender and tailer object is used by one thread at a time, every thread or
+ * process appending to the journal uses its own appender.
+ * Created on 18 October 2026 11:10 PM
+ */
+
+#ifndef BK_CONQ_JOURNAL_HPP
+#define BK_CONQ_JOURNAL_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace bk_conq {
+
+//a file index and a byte offset within the records of that file
+struct journal_position {
+    uint64_t file{ 0 };
+    uint64_t offset{ 0 };
+};
+
+namespace details {
+
+class journal_file {
+public:
+    static constexpr uint64_t magic = 0x626b5f6a726e6c31; //"bk_jrnl1"
+    static constexpr uint32_t version = 1;
+
+    enum record_state : uint32_t {
+        unwritten = 0,
+        published = 1,
+        rolled = 2
+    };
+
+    //the state is only written after the length and the payload
+    struct record_header_t {
+        std::atomic<uint32_t> state;
+        uint32_t length;
+    };
+
+    static constexpr size_t record_alignment = 8;
+
+    journal_file() = default;
+    journal_file(const journal_file&) = delete;
+    void operator=(const journal_file&) = delete;
+
+    ~journal_file() {
+        close();
+    }
+
+    static std::string path(const std::string& directory, uint64_t index) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llu.journal", static_cast<unsigned long long>(index));
+        return directory + "/" + name;
+    }
+
+    //the index of the newest file in directory, or 0 if there is none
+    static uint64_t newest(const std::string& directory) {
+        DIR* dir = ::opendir(directory.c_str());
+        if (!dir) throw std::system_error(errno, std::generic_category(), "opendir " + directory);
+        uint64_t newest = 0;
+        while (dirent* entry = ::readdir(dir)) {
+            unsigned long long index;
+            char suffix[16];
+            if (std::sscanf(entry->d_name, "%16llu.%15s", &index, suffix) == 2 && std::strcmp(suffix, "journal") == 0 && index > newest) {
+                newest = index;
+            }
+        }
+        ::closedir(dir);
+        return newest;
+    }
+
+    static constexpr size_t record_size(size_t length) {
+        return (sizeof(record_header_t) + length + record_alignment - 1) & ~(record_alignment - 1);
+    }
+
+    static constexpr size_t data_offset() {
+        return sizeof(header_t);
+    }
+
+    //maps an existing file, returns false if it does not exist
+    bool open(const std::string& path, bool writable) {
+        close();
+        int fd = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+        if (fd < 0) {
+            if (errno == ENOENT) return false;
+            throw std::system_error(errno, std::generic_category(), "open " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "fstat " + path);
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        if (size < data_offset()) {
+            ::close(fd);
+            throw std::runtime_error("journal file " + path + " is truncated");
+        }
+        void* region = ::mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        int err = errno;
+        ::close(fd);
+        if (region == MAP_FAILED) throw std::system_error(err, std::generic_category(), "mmap " + path);
+        const header_t* header = static_cast<const header_t*>(region);
+        if (header->magic != magic || header->version != version || header->file_bytes != size) {
+            ::munmap(region, size);
+            throw std::runtime_error("journal file " + path + " has a different version or size");
+        }
+        _region = static_cast<char*>(region);
+        _size = size;
+        return true;
+    }
+
+    //maps the file, creating it if it does not exist
+    void create_or_open(const std::string& path, size_t file_bytes) {
+        if (open(path, true)) return;
+        static std::atomic<size_t> next_temporary{ 0 };
+        std::string temporary = path + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(next_temporary.fetch_add(1, std::memory_order_relaxed));
+        int fd = ::open(temporary.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "open " + temporary);
+        void* region = MAP_FAILED;
+        if (::ftruncate(fd, static_cast<off_t>(file_bytes)) == 0) {
+            region = ::mmap(nullptr, file_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        int err = errno;
+        ::close(fd);
+        if (region == MAP_FAILED) {
+            ::unlink(temporary.c_str());
+            throw std::system_error(err, std::generic_category(), "initialize " + temporary);
+        }
+        header_t* header = new (region) header_t;
+        header->file_bytes = file_bytes;
+        ::munmap(region, file_bytes);
+        //the first link wins, later ones find the file already in place
+        if (::link(temporary.c_str(), path.c_str()) != 0 && errno != EEXIST) {
+            err = errno;
+            ::unlink(temporary.c_str());
+            throw std::system_error(err, std::generic_category(), "link " + path);
+        }
+        ::unlink(temporary.c_str());
+        if (!open(path, true)) throw std::runtime_error("journal file " + path + " was removed while opening");
+    }
+
+    void close() {
+        if (_region) ::munmap(_region, _size);
+        _region = nullptr;
+        _size = 0;
+    }
+
+    bool is_open() const {
+        return _region != nullptr;
+    }
+
+    //bytes available for records
+    uint64_t capacity() const {
+        return _size - data_offset();
+    }
+
+    std::atomic<uint64_t>& write_position() {
+        return reinterpret_cast<header_t*>(_region)->write_pos;
+    }
+
+    record_header_t* record(uint64_t offset) {
+        return reinterpret_cast<record_header_t*>(_region + data_offset() + offset);
+    }
+
+    void sync() {
+        if (_region && ::msync(_region, _size, MS_SYNC) != 0) {
+            throw std::system_error(errno, std::generic_category(), "msync");
+        }
+    }
+
+private:
+    //the write position is kept off the line holding the fields that are only read
+    struct header_t {
+        uint64_t magic{ journal_file::magic };
+        uint32_t version{ journal_file::version };
+        uint32_t reserved{ 0 };
+        uint64_t file_bytes{ 0 };
+        alignas(128) std::atomic<uint64_t> write_pos{ 0 };
+        char padding[128 - sizeof(std::atomic<uint64_t>)];
+    };
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free, "shared atomics must be lock free");
+
+    char* _region{ nullptr };
+    size_t _size{ 0 };
+};
+
+}//namespace details
+
+class journal_appender {
+public:
+    //file_bytes is the size of each journal file, and must be a multiple of 8
+    journal_appender(const std::string& directory, size_t file_bytes = size_t(64) << 20) :
+        _directory(directory),
+        _file_bytes(file_bytes),
+        _index(details::journal_file::newest(directory))
+    {
+        if (file_bytes % details::journal_file::record_alignment != 0 || file_bytes <= details::journal_file::data_offset() + sizeof(details::journal_file::record_header_t)) {
+            throw std::length_error("file_bytes of journal_appender must be a multiple of 8 with room for a record");
+        }
+        _file.create_or_open(details::journal_file::path(_directory, _index), _file_bytes);
+    }
+
+    journal_appender(const journal_appender&) = delete;
+    void operator=(const journal_appender&) = delete;
+
+    //appends a record of length bytes written by write(char* destination), and returns its position
+    template <typename F>
+    journal_position append(size_t length, F&& write) {
+        const size_t size = details::journal_file::record_size(length);
+        if (length > UINT32_MAX || size > _file.capacity()) {
+            throw std::length_error("journal record does not fit in a journal file");
+        }
+        while (true) {
+            uint64_t start = _file.write_position().fetch_add(size, std::memory_order_relaxed);
+            uint64_t capacity = _file.capacity();
+            if (start + size <= capacity) {
+                auto* record = _file.record(start);
+                record->length = static_cast<uint32_t>(length);
+                write(reinterpret_cast<char*>(record + 1));
+                record->state.store(details::journal_file::published, std::memory_order_release);
+                return journal_position{ _index, start };
+            }
+            //the reservation that crosses the end marks the file, later ones find it marked or the file full
+            if (start < capacity) {
+                _file.record(start)->state.store(details::journal_file::rolled, std::memory_order_release);
+            }
+            ++_index;
+            _file.create_or_open(details::journal_file::path(_directory, _index), _file_bytes);
+        }
+    }
+
+    journal_position append(const void* data, size_t length) {
+        return append(length, [&](char* destination) { std::memcpy(destination, data, length); });
+    }
+
+    //writes the current file to storage
+    void sync() {
+        _file.sync();
+    }
+
+private:
+    const std::string _directory;
+    const size_t _file_bytes;
+    uint64_t _index;
+    details::journal_file _file;
+};
+
+class journal_tailer {
+public:
+    //reads from start, the position of a record or one saved from position()
+    journal_tailer(const std::string& directory, journal_position start = journal_position{}) :
+        _directory(directory),
+        _position(start)
+    {}
+
+    journal_tailer(const journal_tailer&) = delete;
+    void operator=(const journal_tailer&) = delete;
+
+    //calls f(const char* data, size_t length) with the next record, returns false if no record is available yet
+    template <typename F>
+    bool read(F&& f) {
+        while (true) {
+            if (!_file.is_open() && !_file.open(details::journal_file::path(_directory, _position.file), false)) return false;
+            if (_position.offset + sizeof(details::journal_file::record_header_t) > _file.capacity()) {
+                next_file();
+                continue;
+            }
+            auto* record = _file.record(_position.offset);
+            uint32_t state = record->state.load(std::memory_order_acquire);
+            if (state == details::journal_file::unwritten) return false;
+            if (state == details::journal_file::rolled) {
+                next_file();
+                continue;
+            }
+            f(reinterpret_cast<const char*>(record + 1), static_cast<size_t>(record->length));
+            _position.offset += details::journal_file::record_size(record->length);
+            return true;
+        }
+    }
+
+    bool read(std::vector<char>& output) {
+        return read([&](const char* data, size_t length) { output.assign(data, data + length); });
+    }
+
+    //the position of the next record, a tailer constructed with it continues from here
+    journal_position position() const {
+        return _position;
+    }
+
+private:
+    void next_file() {
+        _file.close();
+        ++_position.file;
+        _position.offset = 0;
+    }
+
+    const std::string _directory;
+    journal_position _position;
+    details::journal_file _file;
+};
+
+}//namespace bk_conq
+
+#endif /* BK_CONQ_JOURNAL_HPP */
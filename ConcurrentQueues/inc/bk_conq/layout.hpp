@@ -0,0 +1,64 @@
+/*
+ * File:   layout.hpp
+ * Author: Barath Kannan
+ * Cache layout policies for the queues. A layout policy decides how far apart
+ * the producer-side and consumer-side indices of a queue are placed, and whether
+ * slot based queues pad each slot out to its own region.
+ * isolated_layout separates hot indices by 128 bytes, which avoids false sharing
+ * on CPUs that prefetch adjacent cache lines in pairs.
+ * isolated_slot_layout additionally pads every slot of slot based queues so that
+ * neighbouring slots' sequence counters never share a line.
+ * compact_layout applies no padding at all and gives the smallest footprint, for
+ * use when very large numbers of mostly idle queues are created.
+ * Created on 18 October 2026, 10:12 AM
+ */
+
+#ifndef BK_CONQ_LAYOUT_HPP
+#define BK_CONQ_LAYOUT_HPP
+
+#include <cstddef>
+#include <initializer_list>
+
+namespace bk_conq {
+
+struct isolated_layout {
+    static constexpr size_t alignment = 128;
+    static constexpr bool pad_slots = false;
+};
+
+struct isolated_slot_layout {
+    static constexpr size_t alignment = 128;
+    static constexpr bool pad_slots = true;
+};
+
+struct compact_layout {
+    static constexpr size_t alignment = 1;
+    static constexpr bool pad_slots = false;
+};
+
+namespace details {
+template <typename... U>
+constexpr size_t max_alignof() {
+    size_t ret = 1;
+    for (size_t a : { alignof(U)... }) {
+        if (a > ret) ret = a;
+    }
+    return ret;
+}
+
+//alignment to apply to a hot member or subqueue, never weaker than the natural alignment of U
+template <typename LAYOUT, typename... U>
+struct layout_alignment {
+    static constexpr size_t value = LAYOUT::alignment > max_alignof<U...>() ? LAYOUT::alignment : max_alignof<U...>();
+};
+
+//alignment to apply to an individual slot of a slot based queue holding members of type U
+template <typename LAYOUT, typename... U>
+struct slot_alignment {
+    static constexpr size_t value = LAYOUT::pad_slots ? layout_alignment<LAYOUT, U...>::value : max_alignof<U...>();
+};
+}//namespace details
+
+}//namespace bk_conq
+
+#endif /* BK_CONQ_LAYOUT_HPP */
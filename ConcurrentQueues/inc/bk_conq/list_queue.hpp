@@ -7,6 +7,14 @@
  * as a linked list, where nodes are stored in a freelist after being dequeued.
  * Enqueue operations will either acquire items from the freelist or allocate a
  * new node if none are available.
+ * A queue may instead be constructed with a node_pool shared with other queues of the
+ * same type, in which case it takes its nodes from the pool and returns each node to
+ * the pool once it is dequeued, and keeps no freelist or storage of its own.
+ * The BUDGET policy decides whether a block of nodes may be allocated once the
+ * freelist is empty (see budget.hpp). With the default unlimited_budget the queue is
+ * unbounded, and with byte_budget it is a bounded queue, constructed with its budget
+ * in bytes, whose enqueues fail once the budget is used up. Pools are only used with
+ * the unlimited budget.
  * Created on 27 August 2016, 11:30 PM
  */
 
@@ -19,52 +27,87 @@
 #include <array>
 #include <memory>
 #include <iostream>
+#include <type_traits>
+#include <bk_conq/bounded_queue.hpp>
 #include <bk_conq/unbounded_queue.hpp>
+#include <bk_conq/budget.hpp>
+#include <bk_conq/layout.hpp>
+#include <bk_conq/node_pool.hpp>
 
 namespace bk_conq {
 
-template<typename T>
-class list_queue : public unbounded_queue<T, list_queue<T>> {
-    friend unbounded_queue<T, list_queue<T>>;
+template<typename T, typename LAYOUT = isolated_layout, typename BUDGET = unlimited_budget>
+class list_queue :
+    public std::conditional_t<BUDGET::bounded, bounded_queue<T, list_queue<T, LAYOUT, BUDGET>>, unbounded_queue<T, list_queue<T, LAYOUT, BUDGET>>>,
+    public BUDGET::template state<LAYOUT>
+{
+    friend bounded_queue<T, list_queue<T, LAYOUT, BUDGET>>;
+    friend unbounded_queue<T, list_queue<T, LAYOUT, BUDGET>>;
+    using budget_t = typename BUDGET::template state<LAYOUT>;
+    struct list_node_t;
 public:
+    using pool_type = node_pool<list_node_t>;
+
+    template <typename B = BUDGET, typename = std::enable_if_t<!B::bounded>>
     list_queue() {
-        std::vector<list_node_t> vec(2);
-        _head.store(&vec[0]);
-        _tail.store(_head.load(std::memory_order_relaxed), std::memory_order_relaxed);
-        _free_list_head.store(&vec[1]);
-        _free_list_tail.store(_free_list_head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        init();
+    }
 
-        storage_node_t *store = new storage_node_t(std::move(vec));
-        storage_node_t* prev_head = _storage_head.exchange(store, std::memory_order_acq_rel);
-        prev_head->next.store(store, std::memory_order_release);
+    //allocates nodes up to budget_bytes
+    template <typename B = BUDGET, typename = std::enable_if_t<B::bounded>>
+    list_queue(size_t budget_bytes) : budget_t(budget_bytes) {
+        init();
+    }
+
+    //takes its nodes from pool and returns them to it
+    template <typename B = BUDGET, typename = std::enable_if_t<!B::bounded>>
+    list_queue(std::shared_ptr<pool_type> pool) : _pool(std::move(pool)) {
+        list_node_t* node = _pool->acquire();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        _head.store(node);
+        _tail.store(node);
+        _free_list_head.store(nullptr);
+        _free_list_tail.store(nullptr);
     }
 
     virtual ~list_queue() {
+        if (_pool) {
+            for (list_node_t* node = _tail.load(std::memory_order_relaxed); node != nullptr; ) {
+                list_node_t* next = node->next.load(std::memory_order_relaxed);
+                _pool->release(node);
+                node = next;
+            }
+        }
         storage_node_t* tail = _storage_tail.load(std::memory_order_relaxed);
-        storage_node_t* next = tail->next.load(std::memory_order_relaxed);
         for (storage_node_t* next = tail->next.load(std::memory_order_relaxed); next != nullptr; ) {
             tail = next;
             next = next->next.load(std::memory_order_relaxed);
             delete tail;
         }
+        delete _storage_tail.load(std::memory_order_relaxed);
     }
 
     list_queue(const list_queue&) = delete;
     void operator=(const list_queue&) = delete;
 
 protected:
+    //only fails when the budget is used up
     template <typename R>
-    void sp_enqueue_impl(R&& input) {
+    bool sp_enqueue_impl(R&& input) {
         list_node_t *node = acquire_or_allocate(std::forward<R>(input));
+        if (!node) return false;
         _head.load(std::memory_order_relaxed)->next.store(node, std::memory_order_release);
         _head.store(node, std::memory_order_relaxed);
+        return true;
     }
 
     template <typename R>
-    void mp_enqueue_impl(R&& input) {
+    bool mp_enqueue_impl(R&& input) {
         list_node_t *node = acquire_or_allocate(std::forward<R>(input));
+        if (!node) return false;
         list_node_t* prev_head = _head.exchange(node, std::memory_order_acq_rel);
         prev_head->next.store(node, std::memory_order_release);
+        return true;
     }
 
     bool sc_dequeue_impl(T& output) {
@@ -129,13 +172,32 @@ private:
         storage_node_t() {}
     };
 
+    void init() {
+        std::vector<list_node_t> vec(2);
+        _head.store(&vec[0]);
+        _tail.store(_head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        _free_list_head.store(&vec[1]);
+        _free_list_tail.store(_free_list_head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        this->allocated(2 * sizeof(list_node_t));
+
+        storage_node_t *store = new storage_node_t(std::move(vec));
+        storage_node_t* prev_head = _storage_head.exchange(store, std::memory_order_acq_rel);
+        prev_head->next.store(store, std::memory_order_release);
+    }
+
     void freelist_enqueue(list_node_t *item) {
+        this->released(sizeof(list_node_t));
+        if (_pool) {
+            _pool->release(item);
+            return;
+        }
         item->next.store(nullptr, std::memory_order_relaxed);
         list_node_t * free_list_prev_head = _free_list_head.exchange(item, std::memory_order_acq_rel);
         free_list_prev_head->next.store(item, std::memory_order_release);
     }
 
     list_node_t* freelist_try_dequeue() {
+        if (_pool) return _pool->acquire();
         list_node_t *item;
         for (item = _free_list_tail.exchange(nullptr, std::memory_order_acq_rel); !item; item = _free_list_tail.exchange(nullptr, std::memory_order_acq_rel)) {
             std::this_thread::yield();
@@ -154,8 +216,9 @@ private:
         //attempt to recycle previously used storage
         list_node_t* node = freelist_try_dequeue();
         if (!node) {
-            //pre-allocate for 32 nodes
+            //pre-allocate for 32 nodes, if the budget allows
             static const size_t allocsize = 32;
+            if (!this->try_allocate(allocsize * sizeof(list_node_t))) return nullptr;
             std::vector<list_node_t> vec(allocsize);
 
             //store the sequencing chain here before it goes on the freelist
@@ -177,16 +240,19 @@ private:
 
         }
         node->data = std::forward<R>(input);
+        //recycled nodes still link to the rest of the freelist
+        node->next.store(nullptr, std::memory_order_relaxed);
+        this->acquired(sizeof(list_node_t));
         return node;
     }
 
-    std::atomic<list_node_t*> _head;
+    alignas(details::layout_alignment<LAYOUT, std::atomic<list_node_t*>>::value) std::atomic<list_node_t*> _head;
     std::atomic<list_node_t*> _free_list_tail;
-    char _padding[64];
-    std::atomic<list_node_t*> _tail;
+    alignas(details::layout_alignment<LAYOUT, std::atomic<list_node_t*>>::value) std::atomic<list_node_t*> _tail;
     std::atomic<list_node_t*> _free_list_head;
     std::atomic<storage_node_t*> _storage_head{ new storage_node_t };
     std::atomic<storage_node_t*> _storage_tail{ _storage_head.load(std::memory_order_relaxed) };
+    const std::shared_ptr<pool_type> _pool;
 
 };
 }//namespace bk_conq
@@ -0,0 +1,171 @@
+/*
+ * File:   lossy_vector_queue.hpp
+ * Author: Barath Kannan
+ * This is a bounded multi-producer multi-consumer ring that never rejects an enqueue.
+ * When the ring is full, a producer overwrites the oldest slot instead, whether or not
+ * its item has been consumed, so the queue keeps the newest N items. It suits telemetry
+ * and trace buffers, where losing old samples is better than blocking or losing new ones.
+ * Producers take a ticket with a single fetch_add and publish the item in the ticket's
+ * slot under a per-slot sequence, in the manner of a seqlock. Consumers read the slot
+ * optimistically and keep the item only if its sequence did not change, and skip any
+ * ticket whose slot has since been overwritten. A consumer that has fallen more than a
+ * lap behind jumps straight to the oldest ticket that can still be present. Skipped
+ * tickets are counted by dropped(). A producer never waits, and if it finds its slot
+ * still being written by a producer a lap behind, it drops its own item and marks the
+ * ticket so that consumers do not wait for it. Neither side takes a lock.
+ * Since items may be read while they are being overwritten, T must be trivially
+ * copyable. The size of the queue must be a power of 2 and at least 2.
+ * Created on 18 October 2026 7:50 PM
+ */
+
+#ifndef BK_CONQ_LOSSYVECTORQUEUE_HPP
+#define BK_CONQ_LOSSYVECTORQUEUE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include <stdexcept>
+#include <bk_conq/bounded_queue.hpp>
+#include <bk_conq/layout.hpp>
+
+namespace bk_conq {
+template<typename T, typename LAYOUT = isolated_layout>
+class lossy_vector_queue : public bounded_queue<T, lossy_vector_queue<T, LAYOUT>> {
+    friend bounded_queue<T, lossy_vector_queue<T, LAYOUT>>;
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+public:
+
+    lossy_vector_queue(size_t N) : _buffer(N), _sm1(N - 1) {
+        if ((N < 2) || ((N & (~N + 1)) != N)) {
+            throw std::length_error("size of lossy_vector_queue must be power of 2 and at least 2");
+        }
+    }
+
+    lossy_vector_queue(const lossy_vector_queue&) = delete;
+    void operator=(const lossy_vector_queue&) = delete;
+
+    //the number of items that were overwritten or dropped before they could be dequeued
+    size_t dropped() const {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+protected:
+    template <typename R>
+    bool sp_enqueue_impl(R&& input) {
+        size_t ticket = _head_seq.load(std::memory_order_relaxed);
+        _head_seq.store(ticket + 1, std::memory_order_relaxed);
+        publish(ticket, input);
+        return true;
+    }
+
+    template <typename R>
+    bool mp_enqueue_impl(R&& input) {
+        publish(_head_seq.fetch_add(1, std::memory_order_relaxed), input);
+        return true;
+    }
+
+    bool sc_dequeue_impl(T& data) {
+        return dequeue<true>(data);
+    }
+
+    bool mc_dequeue_impl(T& data) {
+        return dequeue<false>(data);
+    }
+
+    bool mc_dequeue_uncontended_impl(T& data) {
+        return dequeue<false>(data);
+    }
+
+private:
+    //the item is held in words that are written and read atomically, so reading a slot while it is overwritten is not a data race
+    static constexpr size_t words = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    //seq is 2 * ticket + 1 while the ticket's item is written and 2 * ticket + 2 once it is complete
+    //skip is 1 + the latest ticket whose producer found the slot still being written
+    struct alignas(details::slot_alignment<LAYOUT, std::atomic<size_t>, std::atomic<uint64_t>>::value) node_t {
+        std::atomic<uint64_t> data[words];
+        std::atomic<size_t>   seq{ 0 };
+        std::atomic<size_t>   skip{ 0 };
+    };
+
+    void publish(size_t ticket, const T& input) {
+        node_t& node = _buffer[ticket & _sm1];
+        size_t seq = node.seq.load(std::memory_order_relaxed);
+        do {
+            //a producer a lap ahead has claimed the slot, the item is already superseded
+            if (seq > 2 * ticket) return;
+            if (seq & 1) {
+                //a producer a lap behind is still writing, drop this item rather than wait
+                size_t skip = node.skip.load(std::memory_order_relaxed);
+                while (skip < ticket + 1 && !node.skip.compare_exchange_weak(skip, ticket + 1, std::memory_order_release, std::memory_order_relaxed));
+                return;
+            }
+        } while (!node.seq.compare_exchange_weak(seq, 2 * ticket + 1, std::memory_order_relaxed));
+        //orders the claim ahead of the data, so that a reader seeing any new word sees the slot as changed
+        std::atomic_thread_fence(std::memory_order_release);
+        uint64_t buffer[words] = {};
+        std::memcpy(buffer, &input, sizeof(T));
+        for (size_t i = 0; i < words; ++i) {
+            node.data[i].store(buffer[i], std::memory_order_relaxed);
+        }
+        node.seq.store(2 * ticket + 2, std::memory_order_release);
+    }
+
+    template <bool SINGLE_CONSUMER>
+    bool dequeue(T& data) {
+        size_t ticket = _tail_seq.load(std::memory_order_relaxed);
+        while (true) {
+            node_t& node = _buffer[ticket & _sm1];
+            size_t seq = node.seq.load(std::memory_order_acquire);
+            if (seq == 2 * ticket + 2) {
+                uint64_t buffer[words];
+                for (size_t i = 0; i < words; ++i) {
+                    buffer[i] = node.data[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (node.seq.load(std::memory_order_relaxed) != seq) {
+                    //overwritten while it was read
+                    continue;
+                }
+                if (!advance<SINGLE_CONSUMER>(ticket, ticket + 1)) continue;
+                std::memcpy(&data, buffer, sizeof(T));
+                return true;
+            }
+            size_t next = ticket + 1;
+            if (seq > 2 * ticket + 2) {
+                //the slot was overwritten, tickets more than a lap behind the head are all gone
+                size_t head_seq = _head_seq.load(std::memory_order_relaxed);
+                if (head_seq - ticket > _sm1 + 1) next = head_seq - (_sm1 + 1);
+            }
+            else if (node.skip.load(std::memory_order_acquire) <= ticket) {
+                //the ticket's item is not published yet
+                return false;
+            }
+            if (advance<SINGLE_CONSUMER>(ticket, next)) {
+                _dropped.fetch_add(next - ticket, std::memory_order_relaxed);
+                ticket = next;
+            }
+        }
+    }
+
+    //on failure, ticket is reloaded with the current tail
+    template <bool SINGLE_CONSUMER>
+    bool advance(size_t& ticket, size_t next) {
+        if (SINGLE_CONSUMER) {
+            _tail_seq.store(next, std::memory_order_relaxed);
+            return true;
+        }
+        return _tail_seq.compare_exchange_weak(ticket, next, std::memory_order_relaxed);
+    }
+
+    std::vector<node_t> _buffer;
+    const size_t _sm1;
+    alignas(details::layout_alignment<LAYOUT, std::atomic<size_t>>::value) std::atomic<size_t> _head_seq{ 0 };
+    alignas(details::layout_alignment<LAYOUT, std::atomic<size_t>>::value) std::atomic<size_t> _tail_seq{ 0 };
+    alignas(details::layout_alignment<LAYOUT, std::atomic<size_t>>::value) std::atomic<size_t> _dropped{ 0 };
+};
+} //namespace bk_conq
+
+#endif /* BK_CONQ_LOSSYVECTORQUEUE_HPP */
@@ -2,58 +2,118 @@
  * File:   multi_bounded_queue.hpp
  * Author: Barath Kannan
  * Vector of bounded list queues.
+ * The subqueue count is either given at construction or fixed at compile time
+ * through SUBQUEUES (see static_multi_bounded_queue), in which case the subqueues
+ * are held inline. With SUBQUEUES set to details::dynamic_subqueues (see
+ * dynamic_multi_bounded_queue), subqueues are added as producers arrive, up to a
+ * maximum count. Each subqueue is constructed by the first producer assigned to it,
+ * on that producer's thread, so its memory is placed by first touch and subqueues
+ * that are never used cost only reserved address space. Subqueues left without
+ * producers are retired once a consumer finds them drained and are reused by later
+ * producers, their memory is kept until the queue is destroyed so that consumers in
+ * flight never touch a freed subqueue.
+ * With SPILL set, an enqueue that finds its own subqueue full moves on to the other
+ * subqueues, starting from the subqueue that last accepted a spilled item, and only
+ * fails once every subqueue is full. The total capacity can then be sized for the
+ * aggregate burst rather than per producer. As any producer may enqueue to any
+ * subqueue in this mode, subqueues are never owned exclusively. A spilled item
+ * lands in the subqueue of another producer, behind that producer's items, so the
+ * items of one producer are no longer dequeued in the order they were enqueued
+ * once any of them has spilled.
+ * Consumers favour the subqueues they last dequeued from, which can leave a lightly
+ * loaded subqueue waiting behind busy ones. set_fairness_interval(n) makes every
+ * n-th dequeue of each consumer start from a shared round robin cursor instead, so
+ * a non-empty subqueue is served within roughly (subqueue count * n) dequeues
+ * across all consumers.
  * Created on 28 January 2017, 09:42 AM
  */
 
 #ifndef BK_CONQ_MULTI_BOUNDED_QUEUE_HPP
 #define BK_CONQ_MULTI_BOUNDED_QUEUE_HPP
 
+#include <atomic>
 #include <thread>
 #include <vector>
 #include <mutex>
-#include <memory>
 #include <numeric>
+#include <type_traits>
 #include <bk_conq/bounded_queue.hpp>
+#include <bk_conq/layout.hpp>
 #include <bk_conq/details/tlos.hpp>
+#include <bk_conq/details/queue_traits.hpp>
+#include <bk_conq/details/subqueue_storage.hpp>
+#include <bk_conq/details/subqueue_ownership.hpp>
 
 namespace bk_conq {
-template<typename TT>
-class multi_bounded_queue;
-
-template <template <typename> class Q, typename T>
-class multi_bounded_queue<Q<T>> : public bounded_queue<T, multi_bounded_queue<Q<T>>> {
-    friend bounded_queue<T, multi_bounded_queue<Q<T>>>;
+template<typename Q, typename LAYOUT = isolated_layout, size_t SUBQUEUES = 0, bool SPILL = false>
+class multi_bounded_queue : public bounded_queue<typename details::queue_traits<Q>::value_type, multi_bounded_queue<Q, LAYOUT, SUBQUEUES, SPILL>> {
+    using T = typename details::queue_traits<Q>::value_type;
+    friend bounded_queue<T, multi_bounded_queue<Q, LAYOUT, SUBQUEUES, SPILL>>;
+    static_assert(std::is_base_of<bk_conq::bounded_queue_tag, Q>::value, "Q must be a bounded queue");
 public:
+    //subqueue count chosen at runtime, each subqueue is constructed with size N
+    template <size_t S = SUBQUEUES, typename = std::enable_if_t<S == 0>>
     multi_bounded_queue(size_t N, size_t subqueues) :
-        _hitlist([&]() {return hitlist_sequence(); }),
-        _enqueue_identifier([&]() { return get_enqueue_index(); }, [&](size_t indx) {return return_enqueue_index(indx); })
-    {
-        static_assert(std::is_base_of<bk_conq::bounded_queue_typed_tag<T>, Q<T>>::value, "Q<T> must be a bounded queue");
-        for (size_t i = 0; i < subqueues; ++i) {
-            _q.push_back(std::make_unique<padded_bounded_queue>(N));
-        }
-    }
+        _q(subqueues, N),
+        _ownership(subqueues, !SPILL),
+        _consumer([&]() {return consumer_t{ hitlist_sequence() }; }),
+        _enqueue_identifier([&]() { return get_enqueue_index(); }, [&](details::enqueue_assignment&& assignment) {return return_enqueue_index(assignment); })
+    {}
+
+    //subqueue count fixed at compile time, the arguments are passed to each subqueue
+    template <typename... Args, size_t S = SUBQUEUES, typename = std::enable_if_t<S != 0 && S != details::dynamic_subqueues>>
+    multi_bounded_queue(const Args&... args) :
+        _q(args...),
+        _ownership(SUBQUEUES, !SPILL),
+        _consumer([&]() {return consumer_t{ hitlist_sequence() }; }),
+        _enqueue_identifier([&]() { return get_enqueue_index(); }, [&](details::enqueue_assignment&& assignment) {return return_enqueue_index(assignment); })
+    {}
+
+    //subqueue count grows with the number of producers up to max_subqueues, each subqueue is constructed with size N
+    template <size_t S = SUBQUEUES, typename = std::enable_if_t<S == details::dynamic_subqueues>, typename = void>
+    multi_bounded_queue(size_t N, size_t max_subqueues) :
+        _q(max_subqueues, N),
+        _ownership(0, !SPILL, max_subqueues),
+        _consumer([&]() {return consumer_t{ hitlist_sequence() }; }),
+        _enqueue_identifier([&]() { return get_enqueue_index(); }, [&](details::enqueue_assignment&& assignment) {return return_enqueue_index(assignment); })
+    {}
 
     multi_bounded_queue(const multi_bounded_queue&) = delete;
     void operator=(const multi_bounded_queue&) = delete;
 
+    //0 disables the round robin dequeues
+    void set_fairness_interval(size_t interval) {
+        _fairness_interval.store(interval, std::memory_order_relaxed);
+    }
+
+    //number of subqueues constructed, which only grows in the dynamic form
+    size_t subqueue_count() const {
+        return _q.size();
+    }
+
 protected:
     template <typename R>
     bool sp_enqueue_impl(R&& input) {
-        size_t indx = _enqueue_identifier.get();
-        return _q[indx]->mp_enqueue(std::forward<R>(input));
+        return mp_enqueue_impl(std::forward<R>(input));
     }
 
     template <typename R>
     bool mp_enqueue_impl(R&& input) {
-        size_t indx = _enqueue_identifier.get();
-        return _q[indx]->mp_enqueue(std::forward<R>(input));
+        auto& assignment = _enqueue_identifier.get();
+        //an exclusively owned subqueue has no other producers, so the single-producer path is safe
+        if (_ownership.exclusive(assignment)) {
+            return _q[assignment.indx].sp_enqueue(std::forward<R>(input));
+        }
+        if (_q[assignment.indx].mp_enqueue(std::forward<R>(input))) return true;
+        return SPILL && spill_enqueue(assignment.indx, std::forward<R>(input));
     }
 
     bool sc_dequeue_impl(T& output) {
-        auto& hitlist = _hitlist.get();
+        auto& consumer = get_consumer();
+        if (fairness_turn(consumer) && round_robin_dequeue([&](auto& q) { return q.sc_dequeue(output); })) return true;
+        auto& hitlist = consumer.hitlist;
         for (auto it = hitlist.cbegin(); it != hitlist.cend(); ++it) {
-            if (_q[*it]->sc_dequeue(output)) {
+            if (subqueue_dequeue(*it, [&](auto& q) { return q.sc_dequeue(output); }, true)) {
                 if (hitlist.cbegin() == it) return true;
                 //as below
                 auto nonconstit = hitlist.erase(it, it);
@@ -65,9 +125,11 @@ protected:
     }
 
     bool mc_dequeue_impl(T& output) {
-        auto& hitlist = _hitlist.get();
+        auto& consumer = get_consumer();
+        if (fairness_turn(consumer) && round_robin_dequeue([&](auto& q) { return q.mc_dequeue(output); })) return true;
+        auto& hitlist = consumer.hitlist;
         for (auto it = hitlist.cbegin(); it != hitlist.cend(); ++it) {
-            if (_q[*it]->mc_dequeue_uncontended(output)) {
+            if (subqueue_dequeue(*it, [&](auto& q) { return q.mc_dequeue_uncontended(output); }, false)) {
                 if (hitlist.cbegin() == it) return true;
                 //funky magic - range erase returns an iterator, but an empty range is provided so contents aren't changed
                 //this converts a const iterator to an iterator in constant time
@@ -77,7 +139,7 @@ protected:
             }
         }
         for (auto it = hitlist.cbegin(); it != hitlist.cend(); ++it) {
-            if (_q[*it]->mc_dequeue(output)) {
+            if (subqueue_dequeue(*it, [&](auto& q) { return q.mc_dequeue(output); }, true)) {
                 if (hitlist.cbegin() == it) return true;
                 //as above
                 auto nonconstit = hitlist.erase(it, it);
@@ -89,9 +151,11 @@ protected:
     }
 
     bool mc_dequeue_uncontended_impl(T& output) {
-        auto& hitlist = _hitlist.get();
+        auto& consumer = get_consumer();
+        if (fairness_turn(consumer) && round_robin_dequeue([&](auto& q) { return q.mc_dequeue_uncontended(output); })) return true;
+        auto& hitlist = consumer.hitlist;
         for (auto it = hitlist.cbegin(); it != hitlist.cend(); ++it) {
-            if (_q[*it]->mc_dequeue_uncontended(output)) {
+            if (subqueue_dequeue(*it, [&](auto& q) { return q.mc_dequeue_uncontended(output); }, false)) {
                 if (hitlist.cbegin() == it) return true;
                 //as above
                 auto nonconstit = hitlist.erase(it, it);
@@ -103,42 +167,107 @@ protected:
     }
 
 private:
-    class padded_bounded_queue : public Q<T> {
+    class alignas(details::layout_alignment<LAYOUT, Q>::value) padded_bounded_queue : public Q {
     public:
-        padded_bounded_queue(size_t N) : Q<T>(N) {}
-    private:
-        char padding[64];
+        using Q::Q;
+    };
+
+    struct consumer_t {
+        std::vector<size_t> hitlist;
+        size_t dequeues{ 0 };
     };
 
+    consumer_t& get_consumer() {
+        auto& consumer = _consumer.get();
+        //subqueues added since this consumer last dequeued join the end of its hitlist
+        for (size_t i = consumer.hitlist.size(); i < _q.size(); ++i) consumer.hitlist.push_back(i);
+        return consumer;
+    }
+
+    //retired subqueues are skipped, and an unowned subqueue found empty by a definitive dequeue is retired
+    template <typename F>
+    bool subqueue_dequeue(size_t indx, F&& dequeue, bool definitive) {
+        if constexpr (SUBQUEUES == details::dynamic_subqueues) {
+            size_t state = _ownership.state(indx);
+            if (details::subqueue_ownership::is_retired(state)) return false;
+            if (dequeue(_q[indx])) return true;
+            if (definitive && !SPILL) _ownership.try_retire(indx, state);
+            return false;
+        }
+        else {
+            return dequeue(_q[indx]);
+        }
+    }
+
+    bool fairness_turn(consumer_t& consumer) {
+        size_t interval = _fairness_interval.load(std::memory_order_relaxed);
+        if (interval == 0 || ++consumer.dequeues < interval) return false;
+        consumer.dequeues = 0;
+        return true;
+    }
+
+    //dequeues from the first non-empty subqueue at or after the round robin cursor, the hitlist is left as it is
+    template <typename F>
+    bool round_robin_dequeue(F&& dequeue) {
+        size_t start = _fairness_cursor.fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; i < _q.size(); ++i) {
+            if (subqueue_dequeue((start + i) % _q.size(), dequeue, false)) return true;
+        }
+        return false;
+    }
+
     std::vector<size_t> hitlist_sequence() {
         std::vector<size_t> hitlist(_q.size());
         std::iota(hitlist.begin(), hitlist.end(), 0);
         return hitlist;
     }
 
-    size_t get_enqueue_index() {
-        std::lock_guard<std::mutex> lock(_m);
-        if (_unused_enqueue_indexes.empty()) {
-            return (_enqueue_index++) % _q.size();
+    //probes the other subqueues for space, starting from the subqueue that last accepted a spilled item
+    template <typename R>
+    bool spill_enqueue(size_t home, R&& input) {
+        size_t hint = _spill_hint.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < _q.size(); ++i) {
+            size_t indx = (hint + i) % _q.size();
+            if (indx == home) continue;
+            if (_q[indx].mp_enqueue(std::forward<R>(input))) {
+                if (indx != hint) _spill_hint.store(indx, std::memory_order_relaxed);
+                return true;
+            }
         }
-        size_t ret = _unused_enqueue_indexes.back();
-        _unused_enqueue_indexes.pop_back();
-        return ret;
+        return false;
+    }
+
+    details::enqueue_assignment get_enqueue_index() {
+        return _ownership.acquire([&]() { grow(); });
+    }
+
+    //only called for the dynamic form, which is the only form with a capacity above its subqueue count
+    void grow() {
+        if constexpr (SUBQUEUES == details::dynamic_subqueues) _q.grow();
     }
 
-    void return_enqueue_index(size_t index) {
-        std::lock_guard<std::mutex> lock(_m);
-        _unused_enqueue_indexes.push_back(index);
+    void return_enqueue_index(const details::enqueue_assignment& assignment) {
+        _ownership.release(assignment);
     }
 
-    std::vector<size_t> _unused_enqueue_indexes;
-    std::vector<std::unique_ptr<padded_bounded_queue>> _q;
-    size_t _enqueue_index{ 0 };
-    std::mutex _m;
-    details::tlos<std::vector<size_t>, multi_bounded_queue<Q<T>>> _hitlist;
-    details::tlos<size_t, multi_bounded_queue<Q<T>>> _enqueue_identifier;
+    details::subqueue_storage<padded_bounded_queue, SUBQUEUES> _q;
+    details::subqueue_ownership _ownership;
+    alignas(details::layout_alignment<LAYOUT, std::atomic<size_t>>::value) std::atomic<size_t> _spill_hint{ 0 };
+    std::atomic<size_t> _fairness_interval{ 0 };
+    alignas(details::layout_alignment<LAYOUT, std::atomic<size_t>>::value) std::atomic<size_t> _fairness_cursor{ 0 };
+    details::tlos<consumer_t, multi_bounded_queue<Q, LAYOUT, SUBQUEUES, SPILL>> _consumer;
+    details::tlos<details::enqueue_assignment, multi_bounded_queue<Q, LAYOUT, SUBQUEUES, SPILL>> _enqueue_identifier;
 };
 
+template <typename Q, size_t SUBQUEUES, typename LAYOUT = isolated_layout, bool SPILL = false>
+using static_multi_bounded_queue = multi_bounded_queue<Q, LAYOUT, SUBQUEUES, SPILL>;
+
+template <typename Q, typename LAYOUT = isolated_layout, bool SPILL = false>
+using dynamic_multi_bounded_queue = multi_bounded_queue<Q, LAYOUT, details::dynamic_subqueues, SPILL>;
+
+template <typename Q, typename LAYOUT = isolated_layout>
+using spilling_multi_bounded_queue = multi_bounded_queue<Q, LAYOUT, 0, true>;
+
 }//namespace bk_conq
 
 #endif // BK_CONQ_MULTI_BOUNDED_QUEUE_HPP
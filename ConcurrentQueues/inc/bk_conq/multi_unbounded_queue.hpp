@@ -7,54 +7,111 @@
  * to the subqueues from which a successful dequeue operation has occured. On a
  * successful dequeue operation, the queue that is used is pushed to the front of the
  * list. The "hit lists" allow the queue to adapt fairly well to different usage contexts.
+ * The subqueue count is either given at construction or fixed at compile time
+ * through SUBQUEUES (see static_multi_unbounded_queue), in which case the subqueues
+ * are held inline. With SUBQUEUES set to details::dynamic_subqueues (see
+ * dynamic_multi_unbounded_queue), subqueues are added as producers arrive, up to a
+ * maximum count. Each subqueue is constructed by the first producer assigned to it,
+ * on that producer's thread, so its memory is placed by first touch and subqueues
+ * that are never used cost only reserved address space. Subqueues left without
+ * producers are retired once a consumer finds them drained and are reused by later
+ * producers, their memory is kept until the queue is destroyed so that consumers in
+ * flight never touch a freed subqueue.
+ * Consumers favour the subqueues they last dequeued from, which can leave a lightly
+ * loaded subqueue waiting behind busy ones. set_fairness_interval(n) makes every
+ * n-th dequeue of each consumer start from a shared round robin cursor instead, so
+ * a non-empty subqueue is served within roughly (subqueue count * n) dequeues
+ * across all consumers.
  * Created on 25 September 2016, 12:04 AM
  */
 
 #ifndef BK_CONQ_MULTI_UNBOUNDED_QUEUE_HPP
 #define BK_CONQ_MULTI_UNBOUNDED_QUEUE_HPP
 
+#include <atomic>
 #include <thread>
 #include <vector>
 #include <mutex>
 #include <numeric>
+#include <type_traits>
 #include <bk_conq/unbounded_queue.hpp>
+#include <bk_conq/layout.hpp>
 #include <bk_conq/details/tlos.hpp>
+#include <bk_conq/details/queue_traits.hpp>
+#include <bk_conq/details/subqueue_storage.hpp>
+#include <bk_conq/details/subqueue_ownership.hpp>
 
 namespace bk_conq {
 
-template<typename TT>
-class multi_unbounded_queue;
-
-template <template <typename> class Q, typename T>
-class multi_unbounded_queue<Q<T>> : public unbounded_queue<T, multi_unbounded_queue<Q<T>>> {
-    friend unbounded_queue<T, multi_unbounded_queue<Q<T>>>;
+template<typename Q, typename LAYOUT = isolated_layout, size_t SUBQUEUES = 0>
+class multi_unbounded_queue : public unbounded_queue<typename details::queue_traits<Q>::value_type, multi_unbounded_queue<Q, LAYOUT, SUBQUEUES>> {
+    using T = typename details::queue_traits<Q>::value_type;
+    friend unbounded_queue<T, multi_unbounded_queue<Q, LAYOUT, SUBQUEUES>>;
+    static_assert(std::is_base_of<bk_conq::unbounded_queue_tag, Q>::value, "Q must be an unbounded queue");
 public:
+    //subqueue count chosen at runtime
+    template <size_t S = SUBQUEUES, typename = std::enable_if_t<S == 0>>
     multi_unbounded_queue(size_t subqueues) :
         _q(subqueues),
-        _hitlist([&]() {return hitlist_sequence(); }),
-        _enqueue_identifier([&]() { return get_enqueue_index(); }, [&](padded_unbounded_queue* indx) {return return_enqueue_index(indx); })
-    {
-        static_assert(std::is_base_of<bk_conq::unbounded_queue_typed_tag<T>, Q<T>>::value, "Q<T> must be an unbounded queue");
-    }
+        _ownership(subqueues),
+        _consumer([&]() {return consumer_t{ hitlist_sequence() }; }),
+        _enqueue_identifier([&]() { return get_enqueue_index(); }, [&](details::enqueue_assignment&& assignment) {return return_enqueue_index(assignment); })
+    {}
+
+    //subqueue count fixed at compile time, the arguments are passed to each subqueue
+    template <typename... Args, size_t S = SUBQUEUES, typename = std::enable_if_t<S != 0 && S != details::dynamic_subqueues>>
+    multi_unbounded_queue(const Args&... args) :
+        _q(args...),
+        _ownership(SUBQUEUES),
+        _consumer([&]() {return consumer_t{ hitlist_sequence() }; }),
+        _enqueue_identifier([&]() { return get_enqueue_index(); }, [&](details::enqueue_assignment&& assignment) {return return_enqueue_index(assignment); })
+    {}
+
+    //subqueue count grows with the number of producers up to max_subqueues, the arguments are passed to each subqueue
+    template <typename... Args, size_t S = SUBQUEUES, typename = std::enable_if_t<S == details::dynamic_subqueues>, typename = void>
+    multi_unbounded_queue(size_t max_subqueues, const Args&... args) :
+        _q(max_subqueues, args...),
+        _ownership(0, true, max_subqueues),
+        _consumer([&]() {return consumer_t{ hitlist_sequence() }; }),
+        _enqueue_identifier([&]() { return get_enqueue_index(); }, [&](details::enqueue_assignment&& assignment) {return return_enqueue_index(assignment); })
+    {}
 
     multi_unbounded_queue(const multi_unbounded_queue&) = delete;
     void operator=(const multi_unbounded_queue&) = delete;
 
+    //0 disables the round robin dequeues
+    void set_fairness_interval(size_t interval) {
+        _fairness_interval.store(interval, std::memory_order_relaxed);
+    }
+
+    //number of subqueues constructed, which only grows in the dynamic form
+    size_t subqueue_count() const {
+        return _q.size();
+    }
+
 protected:
     template <typename R>
     void sp_enqueue_impl(R&& input) {
-        _enqueue_identifier.get()->sp_enqueue(std::forward<R>(input));
+        mp_enqueue_impl(std::forward<R>(input));
     }
 
     template <typename R>
     void mp_enqueue_impl(R&& input) {
-        _enqueue_identifier.get()->mp_enqueue(std::forward<R>(input));
+        auto& assignment = _enqueue_identifier.get();
+        //an exclusively owned subqueue has no other producers, so the single-producer path is safe
+        if (_ownership.exclusive(assignment)) {
+            _q[assignment.indx].sp_enqueue(std::forward<R>(input));
+            return;
+        }
+        _q[assignment.indx].mp_enqueue(std::forward<R>(input));
     }
 
     bool sc_dequeue_impl(T& output) {
-        auto& hitlist = _hitlist.get();
+        auto& consumer = get_consumer();
+        if (fairness_turn(consumer) && round_robin_dequeue([&](auto& q) { return q.sc_dequeue(output); })) return true;
+        auto& hitlist = consumer.hitlist;
         for (auto it = hitlist.cbegin(); it != hitlist.cend(); ++it) {
-            if (_q[*it].sc_dequeue(output)) {
+            if (subqueue_dequeue(*it, [&](auto& q) { return q.sc_dequeue(output); }, true)) {
                 if (hitlist.cbegin() == it) return true;
                 //as below
                 auto nonconstit = hitlist.erase(it, it);
@@ -66,9 +123,11 @@ protected:
     }
 
     bool mc_dequeue_impl(T& output) {
-        auto& hitlist = _hitlist.get();
+        auto& consumer = get_consumer();
+        if (fairness_turn(consumer) && round_robin_dequeue([&](auto& q) { return q.mc_dequeue(output); })) return true;
+        auto& hitlist = consumer.hitlist;
         for (auto it = hitlist.cbegin(); it != hitlist.cend(); ++it) {
-            if (_q[*it].mc_dequeue_uncontended(output)) {
+            if (subqueue_dequeue(*it, [&](auto& q) { return q.mc_dequeue_uncontended(output); }, false)) {
                 if (hitlist.cbegin() == it) return true;
                 //funky magic - range erase returns an iterator, but an empty range is provided so contents aren't changed
                 //this converts a const iterator to an iterator in constant time
@@ -78,7 +137,7 @@ protected:
             }
         }
         for (auto it = hitlist.cbegin(); it != hitlist.cend(); ++it) {
-            if (_q[*it].mc_dequeue(output)) {
+            if (subqueue_dequeue(*it, [&](auto& q) { return q.mc_dequeue(output); }, true)) {
                 if (hitlist.cbegin() == it) return true;
                 //as above
                 auto nonconstit = hitlist.erase(it, it);
@@ -90,9 +149,11 @@ protected:
     }
 
     bool mc_dequeue_uncontended_impl(T& output) {
-        auto& hitlist = _hitlist.get();
+        auto& consumer = get_consumer();
+        if (fairness_turn(consumer) && round_robin_dequeue([&](auto& q) { return q.mc_dequeue_uncontended(output); })) return true;
+        auto& hitlist = consumer.hitlist;
         for (auto it = hitlist.cbegin(); it != hitlist.cend(); ++it) {
-            if (_q[*it].mc_dequeue_uncontended(output)) {
+            if (subqueue_dequeue(*it, [&](auto& q) { return q.mc_dequeue_uncontended(output); }, false)) {
                 if (hitlist.cbegin() == it) return true;
                 //as above
                 auto nonconstit = hitlist.erase(it, it);
@@ -104,45 +165,89 @@ protected:
     }
 
 private:
-    class padded_unbounded_queue : public Q<T> {
-        char padding[64];
+    class alignas(details::layout_alignment<LAYOUT, Q>::value) padded_unbounded_queue : public Q {
+    public:
+        using Q::Q;
     };
 
+    struct consumer_t {
+        std::vector<size_t> hitlist;
+        size_t dequeues{ 0 };
+    };
+
+    consumer_t& get_consumer() {
+        auto& consumer = _consumer.get();
+        //subqueues added since this consumer last dequeued join the end of its hitlist
+        for (size_t i = consumer.hitlist.size(); i < _q.size(); ++i) consumer.hitlist.push_back(i);
+        return consumer;
+    }
+
+    //retired subqueues are skipped, and an unowned subqueue found empty by a definitive dequeue is retired
+    template <typename F>
+    bool subqueue_dequeue(size_t indx, F&& dequeue, bool definitive) {
+        if constexpr (SUBQUEUES == details::dynamic_subqueues) {
+            size_t state = _ownership.state(indx);
+            if (details::subqueue_ownership::is_retired(state)) return false;
+            if (dequeue(_q[indx])) return true;
+            if (definitive) _ownership.try_retire(indx, state);
+            return false;
+        }
+        else {
+            return dequeue(_q[indx]);
+        }
+    }
+
+    bool fairness_turn(consumer_t& consumer) {
+        size_t interval = _fairness_interval.load(std::memory_order_relaxed);
+        if (interval == 0 || ++consumer.dequeues < interval) return false;
+        consumer.dequeues = 0;
+        return true;
+    }
+
+    //dequeues from the first non-empty subqueue at or after the round robin cursor, the hitlist is left as it is
+    template <typename F>
+    bool round_robin_dequeue(F&& dequeue) {
+        size_t start = _fairness_cursor.fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; i < _q.size(); ++i) {
+            if (subqueue_dequeue((start + i) % _q.size(), dequeue, false)) return true;
+        }
+        return false;
+    }
+
     std::vector<size_t> hitlist_sequence() {
         std::vector<size_t> hitlist(_q.size());
         std::iota(hitlist.begin(), hitlist.end(), 0);
         return hitlist;
     }
 
-    padded_unbounded_queue* get_enqueue_index() {
-        std::lock_guard<std::mutex> lock(_m);
-        if (_unused_enqueue_indexes.empty()) {
-            return &_q[(_enqueue_index++) % _q.size()];
-        }
-        size_t ret = _unused_enqueue_indexes.back();
-        _unused_enqueue_indexes.pop_back();
-        return &_q[ret];
+    details::enqueue_assignment get_enqueue_index() {
+        return _ownership.acquire([&]() { grow(); });
     }
 
-    void return_enqueue_index(padded_unbounded_queue* index) {
-        std::lock_guard<std::mutex> lock(_m);
-        for (size_t i = 0; i < _q.size(); ++i) {
-            if (&_q[i] == index) {
-                _unused_enqueue_indexes.push_back(i);
-                return;
-            }
-        }
+    //only called for the dynamic form, which is the only form with a capacity above its subqueue count
+    void grow() {
+        if constexpr (SUBQUEUES == details::dynamic_subqueues) _q.grow();
     }
 
-    std::vector<padded_unbounded_queue> _q;
-    std::vector<size_t> _unused_enqueue_indexes;
-    size_t _enqueue_index{ 0 };
-    std::mutex _m;
+    void return_enqueue_index(const details::enqueue_assignment& assignment) {
+        _ownership.release(assignment);
+    }
 
-    details::tlos<std::vector<size_t>, multi_unbounded_queue<Q<T>>> _hitlist;
-    details::tlos<padded_unbounded_queue*, multi_unbounded_queue<Q<T>>> _enqueue_identifier;
+    details::subqueue_storage<padded_unbounded_queue, SUBQUEUES> _q;
+    details::subqueue_ownership _ownership;
+
+    std::atomic<size_t> _fairness_interval{ 0 };
+    alignas(details::layout_alignment<LAYOUT, std::atomic<size_t>>::value) std::atomic<size_t> _fairness_cursor{ 0 };
+    details::tlos<consumer_t, multi_unbounded_queue<Q, LAYOUT, SUBQUEUES>> _consumer;
+    details::tlos<details::enqueue_assignment, multi_unbounded_queue<Q, LAYOUT, SUBQUEUES>> _enqueue_identifier;
 };
 
+template <typename Q, size_t SUBQUEUES, typename LAYOUT = isolated_layout>
+using static_multi_unbounded_queue = multi_unbounded_queue<Q, LAYOUT, SUBQUEUES>;
+
+template <typename Q, typename LAYOUT = isolated_layout>
+using dynamic_multi_unbounded_queue = multi_unbounded_queue<Q, LAYOUT, details::dynamic_subqueues>;
+
 }//namespace bk_conq
 
 #endif /* BK_CONQ_MULTI_UNBOUNDED_QUEUE_HPP */
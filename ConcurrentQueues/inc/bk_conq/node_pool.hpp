@@ -0,0 +1,131 @@
+/*
+ * File:   node_pool.hpp
+ * Author: Barath Kannan
+ * A pool of queue nodes shared by many queues of the same type, so that the nodes a
+ * queue frees can be reused by whichever queue is busy rather than staying on the
+ * freelist of the queue that freed them. A queue constructed with a pool takes its
+ * nodes from the pool and returns them as soon as they are dequeued, and returns
+ * the rest when it is destroyed, so an idle queue holds only its dummy node.
+ * Each thread keeps a cache of up to cache_nodes nodes per pool. A thread whose
+ * cache runs out takes half a cache of nodes from the shared free list, or allocates
+ * them if the free list is empty, and a thread whose cache overflows moves half of it
+ * to the shared free list, both under a mutex. The nodes cached by a thread go back
+ * to the free list when the thread exits. Nodes are only deleted by trim() and when
+ * the pool is destroyed, so the pool must outlive its queues, which hold it through
+ * a std::shared_ptr.
+ * Pools are created through the pool_type of the queue, such as
+ * list_queue<T>::pool_type, since the nodes are particular to the queue type.
+ * Created on 19 October 2026 1:30 AM
+ */
+
+#ifndef BK_CONQ_NODEPOOL_HPP
+#define BK_CONQ_NODEPOOL_HPP
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <bk_conq/details/tlos.hpp>
+
+namespace bk_conq {
+
+template <typename NODE>
+class node_pool {
+public:
+    node_pool(size_t cache_nodes = 64) :
+        _cache_nodes(cache_nodes),
+        _cache([cache_nodes]() {
+            std::vector<NODE*> cache;
+            cache.reserve(cache_nodes + 1);
+            return cache;
+        }, [this](std::vector<NODE*>&& cache) {
+            give_back(cache, cache.size());
+        })
+    {
+        if (cache_nodes < 2) {
+            throw std::length_error("cache_nodes of node_pool must be at least 2");
+        }
+    }
+
+    node_pool(const node_pool&) = delete;
+    void operator=(const node_pool&) = delete;
+
+    //takes a node from the cache of the calling thread, the node keeps the contents it was released with
+    NODE* acquire() {
+        std::vector<NODE*>& cache = _cache.get();
+        if (cache.empty()) refill(cache);
+        NODE* node = cache.back();
+        cache.pop_back();
+        return node;
+    }
+
+    //returns a node that no queue refers to any more
+    void release(NODE* node) {
+        std::vector<NODE*>& cache = _cache.get();
+        cache.push_back(node);
+        if (cache.size() > _cache_nodes) give_back(cache, cache.size() / 2);
+    }
+
+    //deletes free nodes until at most keep are left on the shared free list, nodes cached by threads are kept
+    void trim(size_t keep = 0) {
+        std::vector<NODE*> trimmed;
+        {
+            std::lock_guard<std::mutex> lock(_free.lock);
+            if (_free.nodes.size() <= keep) return;
+            trimmed.assign(_free.nodes.begin() + keep, _free.nodes.end());
+            _free.nodes.resize(keep);
+        }
+        for (NODE* node : trimmed) delete node;
+        _allocated.fetch_sub(trimmed.size(), std::memory_order_relaxed);
+    }
+
+    //number of nodes allocated by the pool and not yet deleted, whether in use or free
+    size_t nodes_allocated() const {
+        return _allocated.load(std::memory_order_relaxed);
+    }
+
+    //number of nodes on the shared free list
+    size_t nodes_free() {
+        std::lock_guard<std::mutex> lock(_free.lock);
+        return _free.nodes.size();
+    }
+
+private:
+    //declared ahead of the caches, so that it is destroyed after they have given their nodes back
+    struct free_list_t {
+        std::mutex lock;
+        std::vector<NODE*> nodes;
+
+        ~free_list_t() {
+            for (NODE* node : nodes) delete node;
+        }
+    };
+
+    void refill(std::vector<NODE*>& cache) {
+        const size_t count = _cache_nodes / 2;
+        {
+            std::lock_guard<std::mutex> lock(_free.lock);
+            size_t taken = count < _free.nodes.size() ? count : _free.nodes.size();
+            cache.insert(cache.end(), _free.nodes.end() - taken, _free.nodes.end());
+            _free.nodes.resize(_free.nodes.size() - taken);
+        }
+        if (!cache.empty()) return;
+        for (size_t i = 0; i < count; ++i) cache.push_back(new NODE);
+        _allocated.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void give_back(std::vector<NODE*>& cache, size_t count) {
+        std::lock_guard<std::mutex> lock(_free.lock);
+        _free.nodes.insert(_free.nodes.end(), cache.end() - count, cache.end());
+        cache.resize(cache.size() - count);
+    }
+
+    const size_t _cache_nodes;
+    std::atomic<size_t> _allocated{ 0 };
+    free_list_t _free;
+    details::tlos<std::vector<NODE*>, node_pool<NODE>> _cache;
+};
+
+}//namespace bk_conq
+
+#endif /* BK_CONQ_NODEPOOL_HPP */
@@ -0,0 +1,115 @@
+/*
+ * File:   partitioned_queue.hpp
+ * Author: Barath Kannan
+ * Vector of queues selected by key. Enqueue operations hash their key to pick a
+ * partition, so that every item with the same key passes through the same subqueue.
+ * Consumers do not dequeue items one at a time. consume() claims a partition that
+ * no other consumer holds, drains up to a batch of items from it into a callback and
+ * releases it. As a partition is drained by at most one consumer at a time, items of
+ * the same key are handled in the order they were enqueued while different partitions
+ * are handled in parallel, and the claiming consumer can use the single-consumer path
+ * of the subqueue. Each consumer starts its search after the last partition it drained,
+ * so busy partitions do not starve the others.
+ * Created on 18 October 2026 6:05 PM
+ */
+
+#ifndef BK_CONQ_PARTITIONED_QUEUE_HPP
+#define BK_CONQ_PARTITIONED_QUEUE_HPP
+
+#include <atomic>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <bk_conq/bounded_queue.hpp>
+#include <bk_conq/unbounded_queue.hpp>
+#include <bk_conq/layout.hpp>
+#include <bk_conq/details/tlos.hpp>
+#include <bk_conq/details/queue_traits.hpp>
+#include <bk_conq/details/subqueue_storage.hpp>
+
+namespace bk_conq {
+
+template<typename Q, typename KEY, typename HASH = std::hash<KEY>, typename LAYOUT = isolated_layout>
+class partitioned_queue {
+    using T = typename details::queue_traits<Q>::value_type;
+public:
+    //the arguments are passed to each partition
+    template <typename... Args>
+    partitioned_queue(size_t partitions, const Args&... args) :
+        _q(partitions, args...),
+        _consumer([&]() { return _next_consumer.fetch_add(1, std::memory_order_relaxed) % _q.size(); })
+    {
+        static_assert(std::is_base_of<bk_conq::bounded_queue_tag, Q>::value || std::is_base_of<bk_conq::unbounded_queue_tag, Q>::value, "Q must be a bounded or unbounded queue");
+    }
+
+    partitioned_queue(const partitioned_queue&) = delete;
+    void operator=(const partitioned_queue&) = delete;
+
+    //returns whatever the enqueue of Q returns
+    template <typename R>
+    decltype(auto) sp_enqueue(const KEY& key, R&& input) {
+        return partition(key).sp_enqueue(std::forward<R>(input));
+    }
+
+    template <typename R>
+    decltype(auto) mp_enqueue(const KEY& key, R&& input) {
+        return partition(key).mp_enqueue(std::forward<R>(input));
+    }
+
+    //passes up to max_items from one partition to f, returns the number of items passed
+    //an item is removed from the queue before it is passed, so it is not redelivered if f throws
+    template <typename F>
+    size_t consume(F&& f, size_t max_items = 64) {
+        size_t& cursor = _consumer.get();
+        for (size_t i = 0; i < _q.size(); ++i) {
+            size_t indx = (cursor + i) % _q.size();
+            partition_t& p = _q[indx];
+            if (p.claimed.load(std::memory_order_relaxed) || p.claimed.exchange(true, std::memory_order_acquire)) continue;
+            claim_guard guard{ p };
+            size_t count = 0;
+            T item;
+            while (count < max_items && p.sc_dequeue(item)) {
+                ++count;
+                f(std::move(item));
+            }
+            if (count) {
+                cursor = indx + 1;
+                return count;
+            }
+        }
+        return 0;
+    }
+
+    size_t partitions() const {
+        return _q.size();
+    }
+
+private:
+    class alignas(details::layout_alignment<LAYOUT, Q>::value) partition_t : public Q {
+    public:
+        using Q::Q;
+        //held by the consumer draining the partition
+        std::atomic<bool> claimed{ false };
+    };
+
+    //the release hands the consumer side of the partition to the next claim
+    struct claim_guard {
+        partition_t& p;
+        ~claim_guard() {
+            p.claimed.store(false, std::memory_order_release);
+        }
+    };
+
+    partition_t& partition(const KEY& key) {
+        return _q[_hash(key) % _q.size()];
+    }
+
+    details::subqueue_storage<partition_t, 0> _q;
+    HASH _hash;
+    std::atomic<size_t> _next_consumer{ 0 };
+    details::tlos<size_t, partitioned_queue<Q, KEY, HASH, LAYOUT>> _consumer;
+};
+
+}//namespace bk_conq
+
+#endif /* BK_CONQ_PARTITIONED_QUEUE_HPP */
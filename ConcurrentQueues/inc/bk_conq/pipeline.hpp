@@ -0,0 +1,170 @@
+/*
+ * File:   pipeline.hpp
+ * Author: Barath Kannan
+ * A chain of worker stages connected by queues. Each stage applies a function to
+ * every item it takes from its input queue and passes the item on by value to its
+ * output queue, and is run by as many threads as its parallelism. Items enter through
+ * push() and leave through pop(). The queue between stages is a batching adapter over
+ * Q (see batching_bounded_queue and batching_unbounded_queue), so Q holds
+ * bk_conq::batch elements and items move between stages a batch at a time. A worker
+ * publishes its partial output batch whenever its input runs dry, so batching adds
+ * no latency once a stage is idle.
+ * With a bounded Q, a worker waits while its output queue is full, which stops it
+ * taking further input and so passes the backpressure upstream to push().
+ * stop() shuts the pipeline down in order. Once the caller's producers have flushed
+ * or exited, it closes the first stage, each stage's workers exit after draining
+ * their input, and the last worker of a stage closes the next one. With a bounded Q,
+ * pop() must keep being called until finished() for stop() to return.
+ * Items are not ordered across the workers of a stage.
+ * Created on 18 October 2026 6:40 PM
+ */
+
+#ifndef BK_CONQ_PIPELINE_HPP
+#define BK_CONQ_PIPELINE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <bk_conq/bounded_queue.hpp>
+#include <bk_conq/batching_bounded_queue.hpp>
+#include <bk_conq/batching_unbounded_queue.hpp>
+#include <bk_conq/details/queue_traits.hpp>
+
+namespace bk_conq {
+
+template<typename Q>
+class pipeline {
+    using batch_t = typename details::queue_traits<Q>::value_type;
+    using T = typename batch_t::value_type;
+    static constexpr bool bounded = std::is_base_of<bk_conq::bounded_queue_tag, Q>::value;
+    using queue_t = std::conditional_t<bounded, batching_bounded_queue<Q>, batching_unbounded_queue<Q>>;
+public:
+    //the arguments are passed to the Q of every queue
+    template <typename... Args>
+    pipeline(const Args&... args) :
+        _construct([args...]() { return std::make_unique<queue_t>(args...); })
+    {
+        _queues.push_back(_construct());
+    }
+
+    ~pipeline() {
+        stop();
+    }
+
+    pipeline(const pipeline&) = delete;
+    void operator=(const pipeline&) = delete;
+
+    //appends a stage run by parallelism threads, f is called as f(T&), stages must be added before start()
+    template <typename F>
+    pipeline& add_stage(size_t parallelism, F&& f) {
+        if (parallelism == 0) throw std::length_error("stage parallelism must be at least 1");
+        _stages.push_back(std::make_unique<stage_t>(std::forward<F>(f), parallelism));
+        _queues.push_back(_construct());
+        return *this;
+    }
+
+    void start() {
+        for (size_t i = 0; i < _stages.size(); ++i) {
+            for (size_t j = 0; j < _stages[i]->parallelism; ++j) {
+                _workers.emplace_back([this, i]() { work(i); });
+            }
+        }
+    }
+
+    //returns whatever the enqueue of the first queue returns
+    template <typename R>
+    decltype(auto) push(R&& input) {
+        return _queues.front()->mp_enqueue(std::forward<R>(input));
+    }
+
+    //publishes the items pushed by the calling thread that are still held in its batch
+    decltype(auto) flush() {
+        return _queues.front()->flush();
+    }
+
+    bool pop(T& output) {
+        return _queues.back()->mc_dequeue(output);
+    }
+
+    //true once every stage has exited after stop(), the items left can still be popped
+    bool finished() const {
+        return _stages.empty() || _stages.back()->running.load(std::memory_order_acquire) == 0;
+    }
+
+    void set_max_linger(std::chrono::nanoseconds linger) {
+        for (auto& q : _queues) q->set_max_linger(linger);
+    }
+
+    void stop() {
+        if (_workers.empty()) return;
+        if (!_stages.empty()) _stages.front()->input_closed.store(true, std::memory_order_release);
+        for (auto& worker : _workers) worker.join();
+        _workers.clear();
+    }
+
+private:
+    struct stage_t {
+        template <typename F>
+        stage_t(F&& f, size_t p) : func(std::forward<F>(f)), parallelism(p), running(p) {}
+
+        std::function<void(T&)> func;
+        const size_t parallelism;
+        std::atomic<size_t> running;
+        std::atomic<bool> input_closed{ false };
+    };
+
+    void work(size_t indx) {
+        stage_t& stage = *_stages[indx];
+        queue_t& in = *_queues[indx];
+        queue_t& out = *_queues[indx + 1];
+        T item;
+        while (true) {
+            //read ahead of the dequeue, so that a closed stage found empty has seen every item
+            bool closed = stage.input_closed.load(std::memory_order_acquire);
+            if (in.mc_dequeue(item)) {
+                stage.func(item);
+                forward(out, std::move(item));
+                continue;
+            }
+            flush(out);
+            if (closed) break;
+            std::this_thread::yield();
+        }
+        //the last worker out has acquired the flushes of the others before closing the next stage
+        if (stage.running.fetch_sub(1, std::memory_order_acq_rel) == 1 && indx + 1 < _stages.size()) {
+            _stages[indx + 1]->input_closed.store(true, std::memory_order_release);
+        }
+    }
+
+    static void forward(queue_t& out, T&& item) {
+        if constexpr (bounded) {
+            while (!out.mp_enqueue(std::move(item))) std::this_thread::yield();
+        }
+        else {
+            out.mp_enqueue(std::move(item));
+        }
+    }
+
+    static void flush(queue_t& out) {
+        if constexpr (bounded) {
+            while (!out.flush()) std::this_thread::yield();
+        }
+        else {
+            out.flush();
+        }
+    }
+
+    std::function<std::unique_ptr<queue_t>()> _construct;
+    std::vector<std::unique_ptr<queue_t>> _queues;
+    std::vector<std::unique_ptr<stage_t>> _stages;
+    std::vector<std::thread> _workers;
+};
+
+}//namespace bk_conq
+
+#endif /* BK_CONQ_PIPELINE_HPP */
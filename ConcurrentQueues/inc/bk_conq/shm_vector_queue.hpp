@@ -0,0 +1,270 @@
+/*
+ * File:   shm_vector_queue.hpp
+ * Author: Barath Kannan
+ * A vector_queue placed in a named POSIX shared memory region, so that producers and
+ * consumers can be separate processes. The region starts with a header recording the
+ * version and layout of the queue, followed by the head and tail sequences and the
+ * slots, and every part is found through offsets recorded in the header, so each
+ * process may map the region at a different address.
+ * Constructing with a name and a size creates the region, which must not already
+ * exist, and marks the header ready once the queue is initialized. Constructing with
+ * only a name attaches to an existing region, and throws if the region is not ready
+ * or its header does not match the version, element type size and alignment, and
+ * layout of the attaching queue. The creating object removes the name when it is
+ * destroyed, processes already attached keep their mapping.
+ * T must be trivially copyable, as its bytes are shared between processes, and the
+ * size of the queue must be a power of 2.
+ * Created on 18 October 2026 9:40 PM
+ */
+
+#ifndef BK_CONQ_SHMVECTORQUEUE_HPP
+#define BK_CONQ_SHMVECTORQUEUE_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <bk_conq/bounded_queue.hpp>
+#include <bk_conq/layout.hpp>
+
+namespace bk_conq {
+template<typename T, typename LAYOUT = isolated_layout>
+class shm_vector_queue : public bounded_queue<T, shm_vector_queue<T, LAYOUT>> {
+    friend bounded_queue<T, shm_vector_queue<T, LAYOUT>>;
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable to be shared between processes");
+    static_assert(std::atomic<size_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free, "shared atomics must be lock free");
+public:
+    static constexpr uint32_t version = 1;
+
+    //creates the region, the name must follow the shm_open rules
+    shm_vector_queue(const std::string& name, size_t N) : _name(name), _owner(true) {
+        if ((N == 0) || ((N & (~N + 1)) != N)) {
+            throw std::length_error("size of shm_vector_queue must be power of 2");
+        }
+        _size = region_size(N);
+        int fd = ::shm_open(_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "shm_open " + _name);
+        if (::ftruncate(fd, static_cast<off_t>(_size)) != 0) {
+            int err = errno;
+            ::close(fd);
+            ::shm_unlink(_name.c_str());
+            throw std::system_error(err, std::generic_category(), "ftruncate " + _name);
+        }
+        map(fd);
+
+        header_t* header = new (_region) header_t;
+        header->value_size = sizeof(T);
+        header->value_align = alignof(T);
+        header->node_size = sizeof(node_t);
+        header->alignment = LAYOUT::alignment;
+        header->capacity = N;
+        header->indices_offset = indices_offset();
+        header->nodes_offset = nodes_offset();
+        header->region_size = _size;
+        resolve(header);
+        new (_indices) indices_t;
+        for (size_t i = 0; i < N; ++i) {
+            new (&_buffer[i]) node_t;
+            _buffer[i].seq.store(i, std::memory_order_relaxed);
+        }
+        //attaching processes see an initialized queue once they see the ready state
+        header->state.store(ready_state, std::memory_order_release);
+    }
+
+    //attaches to a region created by another shm_vector_queue of the same type
+    shm_vector_queue(const std::string& name) : _name(name), _owner(false) {
+        int fd = ::shm_open(_name.c_str(), O_RDWR, 0600);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "shm_open " + _name);
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "fstat " + _name);
+        }
+        if (static_cast<size_t>(st.st_size) < sizeof(header_t)) {
+            ::close(fd);
+            throw std::runtime_error("shm_vector_queue region " + _name + " is not initialized");
+        }
+        _size = static_cast<size_t>(st.st_size);
+        map(fd);
+
+        header_t* header = static_cast<header_t*>(_region);
+        const char* mismatch = nullptr;
+        if (header->state.load(std::memory_order_acquire) != ready_state) mismatch = "is not initialized";
+        else if (header->magic != magic || header->version != version) mismatch = "has a different version";
+        else if (header->value_size != sizeof(T) || header->value_align != alignof(T)) mismatch = "holds a different element type";
+        else if (header->node_size != sizeof(node_t) || header->alignment != LAYOUT::alignment) mismatch = "has a different layout";
+        else if (header->region_size != _size || header->region_size != region_size(header->capacity)) mismatch = "has a different size";
+        if (mismatch) {
+            ::munmap(_region, _size);
+            throw std::runtime_error("shm_vector_queue region " + _name + " " + mismatch);
+        }
+        resolve(header);
+    }
+
+    ~shm_vector_queue() {
+        ::munmap(_region, _size);
+        if (_owner) ::shm_unlink(_name.c_str());
+    }
+
+    shm_vector_queue(const shm_vector_queue&) = delete;
+    void operator=(const shm_vector_queue&) = delete;
+
+    size_t capacity() const {
+        return _sm1 + 1;
+    }
+
+protected:
+    template <typename R>
+    bool sp_enqueue_impl(R&& input) {
+        size_t head_seq = _indices->head_seq.load(std::memory_order_relaxed);
+        node_t& node = _buffer[head_seq & (_sm1)];
+        size_t node_seq = node.seq.load(std::memory_order_acquire);
+        intptr_t dif = (intptr_t)node_seq - (intptr_t)head_seq;
+        if (dif == 0 && _indices->head_seq.compare_exchange_strong(head_seq, head_seq + 1, std::memory_order_relaxed)) {
+            node.data = std::forward<R>(input);
+            node.seq.store(head_seq + 1, std::memory_order_release);
+            return true;
+        }
+        return false;
+    }
+
+    template <typename R>
+    bool mp_enqueue_impl(R&& input) {
+        while (true) {
+            size_t head_seq = _indices->head_seq.load(std::memory_order_relaxed);
+            node_t& node = _buffer[head_seq & (_sm1)];
+            size_t node_seq = node.seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)node_seq - (intptr_t)head_seq;
+            if (dif == 0) {
+                if (_indices->head_seq.compare_exchange_weak(head_seq, head_seq + 1, std::memory_order_relaxed)) {
+                    node.data = std::forward<R>(input);
+                    node.seq.store(head_seq + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (dif < 0) {
+                return false;
+            }
+        }
+    }
+
+    bool sc_dequeue_impl(T& data) {
+        size_t tail_seq = _indices->tail_seq.load(std::memory_order_relaxed);
+        node_t& node = _buffer[tail_seq & (_sm1)];
+        size_t node_seq = node.seq.load(std::memory_order_acquire);
+        intptr_t dif = (intptr_t)node_seq - (intptr_t)(tail_seq + 1);
+        if (dif == 0 && _indices->tail_seq.compare_exchange_strong(tail_seq, tail_seq + 1, std::memory_order_relaxed)) {
+            data = node.data;
+            node.seq.store(tail_seq + _sm1 + 1, std::memory_order_release);
+            return true;
+        }
+        return false;
+    }
+
+    bool mc_dequeue_impl(T& data) {
+        while (true) {
+            size_t tail_seq = _indices->tail_seq.load(std::memory_order_relaxed);
+            node_t& node = _buffer[tail_seq & (_sm1)];
+            size_t node_seq = node.seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)node_seq - (intptr_t)(tail_seq + 1);
+            if (dif == 0) {
+                if (_indices->tail_seq.compare_exchange_weak(tail_seq, tail_seq + 1, std::memory_order_relaxed)) {
+                    data = node.data;
+                    node.seq.store(tail_seq + _sm1 + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (dif < 0) {
+                return false;
+            }
+        }
+    }
+
+    bool mc_dequeue_uncontended_impl(T& data) {
+        return this->sc_dequeue(data);
+    }
+
+private:
+    static constexpr uint64_t magic = 0x626b5f636f6e7131; //"bk_conq1"
+    static constexpr uint32_t ready_state = 1;
+
+    //only fixed width fields, so that the header reads the same in every process
+    struct header_t {
+        uint64_t magic{ shm_vector_queue::magic };
+        uint32_t version{ shm_vector_queue::version };
+        std::atomic<uint32_t> state{ 0 };
+        uint64_t value_size;
+        uint64_t value_align;
+        uint64_t node_size;
+        uint64_t alignment;
+        uint64_t capacity;
+        uint64_t indices_offset;
+        uint64_t nodes_offset;
+        uint64_t region_size;
+    };
+
+    struct indices_t {
+        alignas(details::layout_alignment<LAYOUT, std::atomic<size_t>>::value) std::atomic<size_t> head_seq{ 0 };
+        alignas(details::layout_alignment<LAYOUT, std::atomic<size_t>>::value) std::atomic<size_t> tail_seq{ 0 };
+    };
+
+    struct alignas(details::slot_alignment<LAYOUT, T, std::atomic<size_t>>::value) node_t {
+        T                     data;
+        std::atomic<size_t>   seq;
+    };
+
+    static constexpr size_t align_up(size_t offset, size_t alignment) {
+        return (offset + alignment - 1) & ~(alignment - 1);
+    }
+
+    static constexpr size_t indices_offset() {
+        return align_up(sizeof(header_t), alignof(indices_t));
+    }
+
+    static constexpr size_t nodes_offset() {
+        return align_up(indices_offset() + sizeof(indices_t), alignof(node_t));
+    }
+
+    static size_t region_size(size_t N) {
+        return nodes_offset() + N * sizeof(node_t);
+    }
+
+    //the descriptor is not needed once the region is mapped
+    void map(int fd) {
+        void* region = ::mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        int err = errno;
+        ::close(fd);
+        if (region == MAP_FAILED) {
+            if (_owner) ::shm_unlink(_name.c_str());
+            throw std::system_error(err, std::generic_category(), "mmap " + _name);
+        }
+        _region = region;
+    }
+
+    void resolve(header_t* header) {
+        char* base = static_cast<char*>(_region);
+        _indices = reinterpret_cast<indices_t*>(base + header->indices_offset);
+        _buffer = reinterpret_cast<node_t*>(base + header->nodes_offset);
+        _sm1 = header->capacity - 1;
+    }
+
+    const std::string _name;
+    const bool _owner;
+    void* _region{ nullptr };
+    size_t _size{ 0 };
+    indices_t* _indices{ nullptr };
+    node_t* _buffer{ nullptr };
+    size_t _sm1{ 0 };
+};
+} //namespace bk_conq
+
+#endif /* BK_CONQ_SHMVECTORQUEUE_HPP */
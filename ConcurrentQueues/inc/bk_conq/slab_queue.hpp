@@ -0,0 +1,105 @@
+/*
+ * File:   slab_queue.hpp
+ * Author: Barath Kannan
+ * A bounded multi-producer multi-consumer queue for large items, which keeps the
+ * items out of line in a preallocated slab and passes only their 32 bit slot
+ * indices through two vector queues. A producer takes a free index from the free
+ * ring, writes its item into that slot of the slab and enqueues the index on the
+ * ready ring. A consumer dequeues an index from the ready ring, moves the item out
+ * of its slot and gives the index back to the free ring. Both rings hold every
+ * index of the slab, so neither is ever full when an index is given to it, but a
+ * ring can still report full for the moment a thread that dequeued from it takes
+ * to release the slot, so indices are given to a ring by retrying until it takes
+ * them. The ordering of the ready ring publishes the item written before its index.
+ * The sequence counters of the rings then stay packed together however large T is,
+ * at the cost of a second ring operation and a slab access per item. The size of
+ * the queue must be a power of 2 of at least 2 and at most 2^31, the most
+ * slots a packed vector queue of indices holds.
+ * Created on 19 October 2026 12:40 AM
+ */
+
+#ifndef BK_CONQ_SLABQUEUE_HPP
+#define BK_CONQ_SLABQUEUE_HPP
+
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <bk_conq/bounded_queue.hpp>
+#include <bk_conq/layout.hpp>
+#include <bk_conq/vector_queue.hpp>
+
+namespace bk_conq {
+
+template<typename T, typename LAYOUT = isolated_layout>
+class slab_queue : public bounded_queue<T, slab_queue<T, LAYOUT>> {
+    friend bounded_queue<T, slab_queue<T, LAYOUT>>;
+public:
+    slab_queue(size_t N) : _slab(check_size(N)), _free(N), _ready(N) {
+        for (size_t i = 0; i < N; ++i) {
+            _free.sp_enqueue(static_cast<uint32_t>(i));
+        }
+    }
+
+    slab_queue(const slab_queue&) = delete;
+    void operator=(const slab_queue&) = delete;
+
+protected:
+    template <typename R>
+    bool sp_enqueue_impl(R&& input) {
+        uint32_t index;
+        if (!_free.sc_dequeue(index)) return false;
+        _slab[index] = std::forward<R>(input);
+        while (!_ready.sp_enqueue(index)) std::this_thread::yield();
+        return true;
+    }
+
+    template <typename R>
+    bool mp_enqueue_impl(R&& input) {
+        uint32_t index;
+        if (!_free.mc_dequeue(index)) return false;
+        _slab[index] = std::forward<R>(input);
+        while (!_ready.mp_enqueue(index)) std::this_thread::yield();
+        return true;
+    }
+
+    bool sc_dequeue_impl(T& output) {
+        uint32_t index;
+        if (!_ready.sc_dequeue(index)) return false;
+        output = std::move(_slab[index]);
+        while (!_free.sp_enqueue(index)) std::this_thread::yield();
+        return true;
+    }
+
+    bool mc_dequeue_impl(T& output) {
+        uint32_t index;
+        if (!_ready.mc_dequeue(index)) return false;
+        output = std::move(_slab[index]);
+        while (!_free.mp_enqueue(index)) std::this_thread::yield();
+        return true;
+    }
+
+    bool mc_dequeue_uncontended_impl(T& output) {
+        uint32_t index;
+        if (!_ready.mc_dequeue_uncontended(index)) return false;
+        output = std::move(_slab[index]);
+        while (!_free.mp_enqueue(index)) std::this_thread::yield();
+        return true;
+    }
+
+private:
+    static size_t check_size(size_t N) {
+        if (N < 2 || N > (size_t(1) << 31) || ((N & (~N + 1)) != N)) {
+            throw std::length_error("size of slab_queue must be a power of 2 between 2 and 2^31");
+        }
+        return N;
+    }
+
+    std::vector<T> _slab;
+    vector_queue<uint32_t, LAYOUT> _free;
+    vector_queue<uint32_t, LAYOUT> _ready;
+};
+
+}//namespace bk_conq
+
+#endif /* BK_CONQ_SLABQUEUE_HPP */
@@ -0,0 +1,44 @@
+/*
+ * File:   spill_queue.hpp
+ * Author: Barath Kannan
+ * An unbounded queue with a bounded memory footprint. It is a hybrid_queue whose
+ * ring is a vector_queue and whose overflow is a disk_queue, so enqueues and dequeues
+ * only touch the ring while consumers keep up, and once the ring is full items are
+ * batched into chunks and spilled to segment files, to be read back in order after
+ * the ring has drained. Segment files are written by a writer thread of the disk
+ * queue, so producers only wait for the disk while a previous chunk is still being
+ * written. Beyond the ring, at most three chunks are held in memory.
+ * T must be trivially copyable.
+ * Created on 18 October 2026 10:45 PM
+ */
+
+#ifndef BK_CONQ_SPILLQUEUE_HPP
+#define BK_CONQ_SPILLQUEUE_HPP
+
+#include <string>
+#include <tuple>
+#include <utility>
+#include <bk_conq/hybrid_queue.hpp>
+#include <bk_conq/vector_queue.hpp>
+#include <bk_conq/disk_queue.hpp>
+#include <bk_conq/layout.hpp>
+
+namespace bk_conq {
+
+template<typename T, typename LAYOUT = isolated_layout>
+class spill_queue : public hybrid_queue<vector_queue<T, LAYOUT>, disk_queue<T>, LAYOUT> {
+public:
+    //ring_size must be a power of 2, segment files are created in directory
+    spill_queue(const std::string& directory, size_t ring_size, size_t chunk_items = 65536) :
+        hybrid_queue<vector_queue<T, LAYOUT>, disk_queue<T>, LAYOUT>(std::piecewise_construct, std::make_tuple(ring_size), std::make_tuple(directory, chunk_items))
+    {}
+
+    //number of chunks written to segment files and not yet read back
+    size_t segments_on_disk() const {
+        return this->overflow().segments_on_disk();
+    }
+};
+
+}//namespace bk_conq
+
+#endif /* BK_CONQ_SPILLQUEUE_HPP */
@@ -0,0 +1,24 @@
+/*
+ * File:   static_vector_queue.hpp
+ * Author: Barath Kannan
+ * This is the vector queue with its size fixed at compile time. The ring is held
+ * inline through static_storage and masked with a constant, so indexing can be
+ * folded by the compiler and the queue requires no heap allocation, allowing it to
+ * be placed in static storage or embedded in other objects. It is otherwise the
+ * same queue as vector_queue, including the packing of small items and in place
+ * slots. The size must be a power of 2 and at least 2.
+ * Created on 18 October 2026, 1:20 PM
+ */
+
+#ifndef BK_CONQ_STATICVECTORQUEUE_HPP
+#define BK_CONQ_STATICVECTORQUEUE_HPP
+
+#include <bk_conq/layout.hpp>
+#include <bk_conq/vector_queue.hpp>
+
+namespace bk_conq {
+template<typename T, size_t N, typename LAYOUT = isolated_layout>
+using static_vector_queue = vector_queue<T, LAYOUT, details::packs_into_word<T>::value, static_storage<N>>;
+} //namespace bk_conq
+
+#endif /* BK_CONQ_STATICVECTORQUEUE_HPP */
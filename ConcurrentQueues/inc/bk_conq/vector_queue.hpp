@@ -6,120 +6,409 @@
  * performance gains in those contexts. The queue is an implementation of Dmitry
  * Vyukov's bounded queue and should be used whenever an unbounded queue is not
  * necessary, as it will generally have much better cache locality. The size of
- * the queue must be a power of 2.
+ * the queue must be a power of 2. The LAYOUT policy controls the separation of
+ * the head and tail sequences and the padding of individual slots. The STORAGE
+ * policy decides where the slots are held, heap_storage allocates them when the
+ * queue is constructed and static_storage<N> holds them inline with the size fixed
+ * at compile time, so that the queue needs no allocation and indexing folds to a
+ * constant mask.
+ * Large items can also be written and read in place. try_reserve claims a slot whose
+ * item the producer fills before commit publishes it, and try_acquire claims a slot
+ * whose item the consumer reads before release returns it to producers. A slot that
+ * is reserved or acquired holds up the queue at that slot until it is committed or
+ * released, in the same way as an enqueue or dequeue in progress.
+ * A trivially copyable T of at most 32 bits is packed with the low 32 bits of its
+ * slot sequence into a single 64 bit word, so that a slot is read with one load and
+ * written with one store, and a slot takes 8 bytes instead of 16. This is selected
+ * by the PACKED parameter, which defaults to whether T fits, and chooses the slot
+ * traits through which the ring reads and writes its slots. A packed queue holds
+ * at most 2^31 slots. The slots of a packed queue hold copies of the items, so a
+ * reserved or acquired slot refers to a copy held by the slot handle, which commit
+ * writes to the queue.
  * Created on 3 September 2016, 2:49 PM
  */
 
 #ifndef BK_CONQ_VECTORQUEUE_HPP
 #define BK_CONQ_VECTORQUEUE_HPP
 
+#include <array>
 #include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <type_traits>
 #include <vector>
 #include <stdexcept>
 #include <bk_conq/bounded_queue.hpp>
+#include <bk_conq/layout.hpp>
 
 namespace bk_conq {
-template<typename T>
-class vector_queue : public bounded_queue<T, vector_queue<T>> {
-    friend bounded_queue<T, vector_queue<T>>;
+namespace details {
+//whether T can share a 64 bit slot word with 32 bits of sequence
+template <typename T>
+struct packs_into_word {
+    static constexpr bool value = std::is_trivially_copyable<T>::value && std::is_default_constructible<T>::value && sizeof(T) <= sizeof(uint32_t);
+};
+
+//slots holding the item beside a full width sequence, a claimed slot is read and written in place
+template <typename T, typename LAYOUT>
+struct split_slot {
+    struct alignas(slot_alignment<LAYOUT, T, std::atomic<size_t>>::value) node_t {
+        T                     data;
+        std::atomic<size_t>   seq;
+    };
+
+    using state_t = size_t;
+    static constexpr size_t max_slots = ~size_t(0);
+
+    struct held_t {
+        T& item(node_t& node) {
+            return node.data;
+        }
+    };
+
+    static void init(node_t& node, size_t seq) {
+        node.seq.store(seq, std::memory_order_relaxed);
+    }
+
+    static state_t load(node_t& node) {
+        return node.seq.load(std::memory_order_acquire);
+    }
+
+    static intptr_t difference(state_t state, size_t seq) {
+        return (intptr_t)state - (intptr_t)seq;
+    }
+
+    template <typename R>
+    static void write(node_t& node, size_t seq, R&& input) {
+        node.data = std::forward<R>(input);
+        node.seq.store(seq, std::memory_order_release);
+    }
+
+    static void read(node_t& node, state_t, T& data) {
+        data = std::move(node.data);
+    }
+
+    static void free(node_t& node, size_t seq) {
+        node.seq.store(seq, std::memory_order_release);
+    }
+
+    static void acquire(node_t&, state_t, held_t&) {}
+
+    static void commit(node_t& node, size_t seq, held_t&) {
+        node.seq.store(seq, std::memory_order_release);
+    }
+};
+
+//slots of a small trivially copyable T, the sequence is in the high 32 bits of the slot word and the item in the low 32 bits
+template <typename T, typename LAYOUT>
+struct packed_slot {
+    static_assert(packs_into_word<T>::value, "T must be a trivially copyable type of at most 32 bits to be packed");
+
+    struct alignas(slot_alignment<LAYOUT, std::atomic<uint64_t>>::value) node_t {
+        std::atomic<uint64_t> word;
+    };
+
+    using state_t = uint64_t;
+    static constexpr size_t max_slots = size_t(1) << 31;
+
+    //a claimed slot holds a copy of its item, which commit writes to the slot
+    struct held_t {
+        T data{};
+
+        T& item(node_t&) {
+            return data;
+        }
+    };
+
+    static void init(node_t& node, size_t seq) {
+        node.word.store(pack_bits(seq, 0), std::memory_order_relaxed);
+    }
+
+    static state_t load(node_t& node) {
+        return node.word.load(std::memory_order_acquire);
+    }
+
+    //the distance of the slot sequence from seq, which never exceeds the size of the queue
+    static intptr_t difference(state_t state, size_t seq) {
+        return static_cast<int32_t>(static_cast<uint32_t>(state >> 32) - static_cast<uint32_t>(seq));
+    }
+
+    template <typename R>
+    static void write(node_t& node, size_t seq, R&& input) {
+        node.word.store(pack(seq, T(std::forward<R>(input))), std::memory_order_release);
+    }
+
+    static void read(node_t&, state_t state, T& data) {
+        unpack(state, data);
+    }
+
+    static void free(node_t& node, size_t seq) {
+        node.word.store(pack_bits(seq, 0), std::memory_order_release);
+    }
+
+    static void acquire(node_t&, state_t state, held_t& held) {
+        unpack(state, held.data);
+    }
+
+    static void commit(node_t& node, size_t seq, held_t& held) {
+        node.word.store(pack(seq, held.data), std::memory_order_release);
+    }
+
+    static uint64_t pack_bits(size_t seq, uint32_t bits) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(seq)) << 32) | bits;
+    }
+
+    static uint64_t pack(size_t seq, const T& item) {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &item, sizeof(T));
+        return pack_bits(seq, bits);
+    }
+
+    static void unpack(uint64_t word, T& item) {
+        uint32_t bits = static_cast<uint32_t>(word);
+        std::memcpy(&item, &bits, sizeof(T));
+    }
+};
+}//namespace details
+
+//the slots are allocated on the heap, with the size given to the constructor of the queue
+struct heap_storage {
+    template <typename NODE>
+    class slots {
+    public:
+        slots(size_t N) : _buffer(N), _sm1(N - 1) {}
+
+        NODE& slot(size_t seq) {
+            return _buffer[seq & _sm1];
+        }
+
+        size_t size() const {
+            return _sm1 + 1;
+        }
+
+    private:
+        std::vector<NODE> _buffer;
+        const size_t _sm1;
+    };
+};
+
+//the slots are held inline in the queue, with the size fixed at compile time so that indexing folds to a constant mask
+template <size_t N>
+struct static_storage {
+    static_assert(N >= 2 && (N & (~N + 1)) == N, "size of static_storage must be power of 2");
+    static constexpr size_t size = N;
+
+    template <typename NODE>
+    class slots {
+    public:
+        slots(size_t n) {
+            if (n != N) {
+                throw std::length_error("size of vector_queue must be the size of its static storage");
+            }
+        }
+
+        NODE& slot(size_t seq) {
+            return _buffer[seq & (N - 1)];
+        }
+
+        static constexpr size_t size() {
+            return N;
+        }
+
+    private:
+        std::array<NODE, N> _buffer;
+    };
+};
+
+template<typename T, typename LAYOUT = isolated_layout, bool PACKED = details::packs_into_word<T>::value, typename STORAGE = heap_storage>
+class vector_queue : public bounded_queue<T, vector_queue<T, LAYOUT, PACKED, STORAGE>> {
+    friend bounded_queue<T, vector_queue<T, LAYOUT, PACKED, STORAGE>>;
+    using slot_traits = typename std::conditional<PACKED, details::packed_slot<T, LAYOUT>, details::split_slot<T, LAYOUT>>::type;
+    using node_t = typename slot_traits::node_t;
+    using state_t = typename slot_traits::state_t;
 public:
 
-    vector_queue(size_t N) : _buffer(N), _sm1(N - 1) {
+    vector_queue(size_t N) : _buffer(N) {
         if ((N == 0) || ((N & (~N + 1)) != N)) {
             throw std::length_error("size of vector_queue must be power of 2");
         }
+        if (N > slot_traits::max_slots) {
+            throw std::length_error("size of packed vector_queue must be at most 2^31");
+        }
         for (size_t i = 0; i < N; ++i) {
-            _buffer[i].seq.store(i, std::memory_order_relaxed);
+            slot_traits::init(_buffer.slot(i), i);
         }
     }
 
+    //constructs a queue of the size fixed by static storage
+    vector_queue() : vector_queue(STORAGE::size) {}
+
     vector_queue(const vector_queue&) = delete;
     void operator=(const vector_queue&) = delete;
 
+    //a claimed slot, empty if the claim failed
+    template <bool WRITE>
+    class slot_handle {
+    public:
+        slot_handle() = default;
+
+        explicit operator bool() const {
+            return _node != nullptr;
+        }
+
+        T& operator*() const {
+            return _held.item(*_node);
+        }
+
+        T* operator->() const {
+            return &_held.item(*_node);
+        }
+
+    private:
+        friend class vector_queue;
+        slot_handle(node_t* node, size_t seq) : _node(node), _seq(seq) {}
+
+        node_t* _node{ nullptr };
+        size_t _seq{ 0 };
+        mutable typename slot_traits::held_t _held{};
+    };
+
+    using write_slot = slot_handle<true>;
+    using read_slot = slot_handle<false>;
+
+    //claims the slot at the head for a single producer, the item is written to the slot and then committed
+    write_slot sp_try_reserve() {
+        size_t head_seq;
+        node_t* node = claim_head<false>(head_seq);
+        return node ? write_slot(node, head_seq) : write_slot();
+    }
+
+    write_slot mp_try_reserve() {
+        size_t head_seq;
+        node_t* node = claim_head<true>(head_seq);
+        return node ? write_slot(node, head_seq) : write_slot();
+    }
+
+    //publishes the item of a reserved slot to consumers
+    void commit(write_slot& slot) {
+        slot_traits::commit(*slot._node, slot._seq + 1, slot._held);
+        slot._node = nullptr;
+    }
+
+    //claims the slot at the tail for a single consumer, the item is read from the slot and then released
+    read_slot sc_try_acquire() {
+        return acquire<false>();
+    }
+
+    read_slot mc_try_acquire() {
+        return acquire<true>();
+    }
+
+    //returns an acquired slot to producers
+    void release(read_slot& slot) {
+        slot_traits::free(*slot._node, slot._seq + _buffer.size());
+        slot._node = nullptr;
+    }
+
 protected:
     template <typename R>
     bool sp_enqueue_impl(R&& input) {
-        size_t head_seq = _head_seq.load(std::memory_order_relaxed);
-        node_t& node = _buffer[head_seq & (_sm1)];
-        size_t node_seq = node.seq.load(std::memory_order_acquire);
-        intptr_t dif = (intptr_t)node_seq - (intptr_t)head_seq;
-        if (dif == 0 && _head_seq.compare_exchange_strong(head_seq, head_seq + 1, std::memory_order_relaxed)) {
-            node.data = std::forward<R>(input);
-            node.seq.store(head_seq + 1, std::memory_order_release);
-        }
-        return false;
+        return enqueue<false>(std::forward<R>(input));
     }
 
     template <typename R>
     bool mp_enqueue_impl(R&& input) {
+        return enqueue<true>(std::forward<R>(input));
+    }
+
+    bool sc_dequeue_impl(T& data) {
+        return dequeue<false>(data);
+    }
+
+    bool mc_dequeue_impl(T& data) {
+        return dequeue<true>(data);
+    }
+
+    bool mc_dequeue_uncontended_impl(T& data) {
+        return this->sc_dequeue(data);
+    }
+
+private:
+    //claims the slot at the head, a single producer gives up on the first failed exchange
+    template <bool MULTI>
+    node_t* claim_head(size_t& head_seq) {
         while (true) {
-            size_t head_seq = _head_seq.load(std::memory_order_relaxed);
-            node_t& node = _buffer[head_seq & (_sm1)];
-            size_t node_seq = node.seq.load(std::memory_order_acquire);
-            intptr_t dif = (intptr_t)node_seq - (intptr_t)head_seq;
+            head_seq = _head_seq.load(std::memory_order_relaxed);
+            node_t& node = _buffer.slot(head_seq);
+            intptr_t dif = slot_traits::difference(slot_traits::load(node), head_seq);
             if (dif == 0) {
-                if (_head_seq.compare_exchange_weak(head_seq, head_seq + 1, std::memory_order_relaxed)) {
-                    node.data = std::forward<R>(input);
-                    node.seq.store(head_seq + 1, std::memory_order_release);
-                    return true;
+                if (MULTI ? _head_seq.compare_exchange_weak(head_seq, head_seq + 1, std::memory_order_relaxed)
+                          : _head_seq.compare_exchange_strong(head_seq, head_seq + 1, std::memory_order_relaxed)) {
+                    return &node;
                 }
             }
             else if (dif < 0) {
-                return false;
+                return nullptr;
             }
+            if (!MULTI) return nullptr;
         }
     }
 
-    bool sc_dequeue_impl(T& data) {
-        size_t tail_seq = _tail_seq.load(std::memory_order_relaxed);
-        node_t& node = _buffer[tail_seq & (_sm1)];
-        size_t node_seq = node.seq.load(std::memory_order_acquire);
-        intptr_t dif = (intptr_t)node_seq - (intptr_t)(tail_seq + 1);
-        if (dif == 0 && _tail_seq.compare_exchange_strong(tail_seq, tail_seq + 1, std::memory_order_relaxed)) {
-            data = std::move(node.data);
-            node.seq.store(tail_seq + _sm1 + 1, std::memory_order_release);
-            return true;
-        }
-        return false;
-    }
-
-    bool mc_dequeue_impl(T& data) {
+    //claims the slot at the tail, along with the state it was claimed in
+    template <bool MULTI>
+    node_t* claim_tail(size_t& tail_seq, state_t& state) {
         while (true) {
-            size_t tail_seq = _tail_seq.load(std::memory_order_relaxed);
-            node_t& node = _buffer[tail_seq & (_sm1)];
-            size_t node_seq = node.seq.load(std::memory_order_acquire);
-            intptr_t dif = (intptr_t)node_seq - (intptr_t)(tail_seq + 1);
+            tail_seq = _tail_seq.load(std::memory_order_relaxed);
+            node_t& node = _buffer.slot(tail_seq);
+            state = slot_traits::load(node);
+            intptr_t dif = slot_traits::difference(state, tail_seq + 1);
             if (dif == 0) {
-                if (_tail_seq.compare_exchange_weak(tail_seq, tail_seq + 1, std::memory_order_relaxed)) {
-                    data = std::move(node.data);
-                    node.seq.store(tail_seq + _sm1 + 1, std::memory_order_release);
-                    return true;
+                if (MULTI ? _tail_seq.compare_exchange_weak(tail_seq, tail_seq + 1, std::memory_order_relaxed)
+                          : _tail_seq.compare_exchange_strong(tail_seq, tail_seq + 1, std::memory_order_relaxed)) {
+                    return &node;
                 }
             }
             else if (dif < 0) {
-                return false;
+                return nullptr;
             }
+            if (!MULTI) return nullptr;
         }
     }
 
-    bool mc_dequeue_uncontended_impl(T& data) {
-        return this->sc_dequeue(data);
+    template <bool MULTI, typename R>
+    bool enqueue(R&& input) {
+        size_t head_seq;
+        node_t* node = claim_head<MULTI>(head_seq);
+        if (!node) return false;
+        slot_traits::write(*node, head_seq + 1, std::forward<R>(input));
+        return true;
     }
 
-private:
-    struct node_t {
-        T                     data;
-        std::atomic<size_t>   seq;
-    };
+    template <bool MULTI>
+    bool dequeue(T& data) {
+        size_t tail_seq;
+        state_t state;
+        node_t* node = claim_tail<MULTI>(tail_seq, state);
+        if (!node) return false;
+        slot_traits::read(*node, state, data);
+        slot_traits::free(*node, tail_seq + _buffer.size());
+        return true;
+    }
+
+    template <bool MULTI>
+    read_slot acquire() {
+        size_t tail_seq;
+        state_t state;
+        node_t* node = claim_tail<MULTI>(tail_seq, state);
+        if (!node) return read_slot();
+        read_slot slot(node, tail_seq);
+        slot_traits::acquire(*node, state, slot._held);
+        return slot;
+    }
 
-    std::vector<node_t> _buffer;
-    char _pad0[64];
-    std::atomic<size_t> _head_seq{ 0 };
-    char _pad1[64];
-    std::atomic<size_t> _tail_seq{ 0 };
-    char _pad2[64];
-    const size_t _sm1;
+    typename STORAGE::template slots<node_t> _buffer;
+    alignas(details::layout_alignment<LAYOUT, std::atomic<size_t>>::value) std::atomic<size_t> _head_seq{ 0 };
+    alignas(details::layout_alignment<LAYOUT, std::atomic<size_t>>::value) std::atomic<size_t> _tail_seq{ 0 };
 };
 } //namespace bk_conq
 
@@ -5,6 +5,18 @@ using qtype = bk_conq::bounded_list_queue<QueueTest::queue_test_type_t>;
 using mqtype = bk_conq::multi_bounded_queue<qtype>;
 using bqtype = bk_conq::blocking_bounded_queue<qtype>;
 using bmqtype = bk_conq::blocking_bounded_queue<mqtype>;
+using cqtype = bk_conq::bounded_list_queue<QueueTest::queue_test_type_t, bk_conq::compact_layout>;
+using mcqtype = bk_conq::multi_bounded_queue<cqtype, bk_conq::compact_layout>;
+
+//a budget of about N nodes, so the tests compare with a bounded_list_queue of size N
+struct budgeted_qtype : bk_conq::budgeted_list_queue<QueueTest::queue_test_type_t> {
+    budgeted_qtype(size_t N) : bk_conq::budgeted_list_queue<QueueTest::queue_test_type_t>(N * (sizeof(QueueTest::queue_test_type_t) + sizeof(void*))) {}
+};
+using bbgqtype = bk_conq::blocking_bounded_queue<budgeted_qtype>;
+
+//32 bit items, which share a node with its 32 bit next index without padding
+template <typename LAYOUT>
+using lnarrow_qtype = narrow_qtype<bk_conq::bounded_list_queue<uint32_t, LAYOUT>>;
 
 TEST_P(QueueTest, bounded_list_queue) {
     QueueTest::TemplatedTest<qtype, queue_test_type_t>();
@@ -22,4 +34,30 @@ TEST_P(QueueTest, multi_bounded_list_queue_blocking) {
     QueueTest::BlockingTest<bmqtype, queue_test_type_t>(_params.subqueueSize);
 }
 
+TEST_P(QueueTest, bounded_list_queue_compact) {
+    QueueTest::TemplatedTest<cqtype, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, multi_bounded_list_queue_compact) {
+    QueueTest::TemplatedTest<mcqtype, queue_test_type_t>(_params.subqueueSize);
+}
+
+TEST_P(QueueTest, budgeted_list_queue) {
+    QueueTest::TemplatedTest<budgeted_qtype, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, budgeted_list_queue_blocking) {
+    QueueTest::BlockingTest<bbgqtype, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, bounded_list_queue_narrow) {
+    std::cout << "Bytes per node: " << lnarrow_qtype<bk_conq::isolated_layout>::queue_t::node_bytes() << std::endl;
+    QueueTest::TemplatedTest<lnarrow_qtype<bk_conq::isolated_layout>, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, bounded_list_queue_narrow_compact) {
+    std::cout << "Bytes per node: " << lnarrow_qtype<bk_conq::compact_layout>::queue_t::node_bytes() << std::endl;
+    QueueTest::TemplatedTest<lnarrow_qtype<bk_conq::compact_layout>, queue_test_type_t>();
+}
+
 }
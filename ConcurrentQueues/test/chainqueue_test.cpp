@@ -5,6 +5,8 @@ using qtype = bk_conq::chain_queue<QueueTest::queue_test_type_t>;
 using mqtype = bk_conq::multi_unbounded_queue<qtype>;
 using bqtype = bk_conq::blocking_unbounded_queue<qtype>;
 using bmqtype = bk_conq::blocking_unbounded_queue<mqtype>;
+using cqtype = bk_conq::chain_queue<QueueTest::queue_test_type_t, bk_conq::compact_layout>;
+using mcqtype = bk_conq::multi_unbounded_queue<cqtype, bk_conq::compact_layout>;
 
 TEST_P(QueueTest, chain_queue) {
     QueueTest::TemplatedTest<qtype, queue_test_type_t>(false);
@@ -38,4 +40,16 @@ TEST_P(QueueTest, multi_chain_queue_blocking_prefill) {
     QueueTest::BlockingTest<bmqtype, queue_test_type_t>(true, _params.subqueueSize);
 }
 
-}
\ No newline at end of file
+TEST_P(QueueTest, chain_queue_compact) {
+    QueueTest::TemplatedTest<cqtype, queue_test_type_t>(false);
+}
+
+TEST_P(QueueTest, multi_chain_queue_compact) {
+    QueueTest::TemplatedTest<mcqtype, queue_test_type_t>(false, _params.subqueueSize);
+}
+
+TEST_P(QueueTest, chain_queue_pooled) {
+    QueueTest::TemplatedTest<qtype, queue_test_type_t>(false, std::make_shared<qtype::pool_type>());
+}
+
+}
@@ -10,14 +10,31 @@
 
 #include <gtest/gtest.h>
 #include <iostream>
+#include <chrono>
+#include <atomic>
 #include <bk_conq/blocking_unbounded_queue.hpp>
 #include <bk_conq/blocking_bounded_queue.hpp>
 #include <bk_conq/multi_bounded_queue.hpp>
 #include <bk_conq/multi_unbounded_queue.hpp>
+#include <bk_conq/adaptive_bounded_queue.hpp>
+#include <bk_conq/adaptive_unbounded_queue.hpp>
+#include <bk_conq/batching_bounded_queue.hpp>
+#include <bk_conq/batching_unbounded_queue.hpp>
+#include <bk_conq/partitioned_queue.hpp>
+#include <bk_conq/pipeline.hpp>
+#include <bk_conq/conflating_queue.hpp>
+#include <bk_conq/hybrid_queue.hpp>
+#include <bk_conq/lossy_vector_queue.hpp>
 #include <bk_conq/bounded_list_queue.hpp>
+#include <bk_conq/budgeted_list_queue.hpp>
+#include <bk_conq/byte_ring.hpp>
+#include <bk_conq/slab_queue.hpp>
 #include <bk_conq/vector_queue.hpp>
+#include <bk_conq/growable_vector_queue.hpp>
+#include <bk_conq/static_vector_queue.hpp>
 #include <bk_conq/list_queue.hpp>
 #include <bk_conq/chain_queue.hpp>
+#include <bk_conq/node_pool.hpp>
 #include "basic_timer.h"
 
 enum QueueTestType : uint32_t {
@@ -67,6 +84,7 @@ protected:
     template<typename T, typename R, typename ...Args>
     void GenericTest(std::function<void(T&, R&) > dequeueOperation, std::function<void(T&, R) > enqueueOperation, bool prefill, Args... args) {
         T q{ args... };
+        std::cout << "Queue object size: " << sizeof(T) << " bytes" << std::endl;
         std::vector<std::thread> l;
         for (int i = 0; i < (prefill ? 2 : 1); ++i) {
             _startFlag.store(false);
@@ -120,6 +138,382 @@ protected:
 
     }
 
+    //enqueues timestamps tagged with the writing thread and reports the longest time an item from each writer spent queued
+    template<typename T, typename R, typename ...Args>
+    void SojournTest(std::function<void(T&, R&) > dequeueOperation, std::function<void(T&, R) > enqueueOperation, Args... args) {
+        static_assert(std::is_same<R, size_t>::value, "sojourn test items must be size_t timestamps");
+        const size_t writerBits = 16;
+        auto start = std::chrono::steady_clock::now();
+        auto stamp = [start]() {
+            return static_cast<size_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        };
+        std::vector<std::atomic<size_t>> maxSojourn(_params.nWriters);
+        std::atomic<size_t> nextWriter{ 0 };
+        std::function<void(T&, R) > stampedEnqueue = [&](T& q, R) {
+            thread_local size_t writer = nextWriter++ % _params.nWriters;
+            enqueueOperation(q, (stamp() << writerBits) | writer);
+        };
+        std::function<void(T&, R&) > timedDequeue = [&](T& q, R& item) {
+            dequeueOperation(q, item);
+            size_t sojourn = stamp() - (item >> writerBits);
+            auto& writerMax = maxSojourn[item & ((size_t(1) << writerBits) - 1)];
+            size_t prev = writerMax.load(std::memory_order_relaxed);
+            while (sojourn > prev && !writerMax.compare_exchange_weak(prev, sojourn, std::memory_order_relaxed));
+        };
+        GenericTest<T, R>(timedDequeue, stampedEnqueue, false, args...);
+        size_t worst = 0;
+        for (size_t i = 0; i < _params.nWriters; ++i) {
+            std::cout << "Max sojourn time (writer " << i << "): " << maxSojourn[i].load() / 1000.0 << " microseconds" << std::endl;
+            if (maxSojourn[i].load() > worst) worst = maxSojourn[i].load();
+        }
+        std::cout << "Max sojourn time (all writers): " << worst / 1000.0 << " microseconds" << std::endl;
+    }
+
+    //writers enqueue items under keys and readers consume them through consume(), the order of every writer's items under each key is checked
+    template<typename T, typename ...Args>
+    void KeyedTest(size_t keys, Args... args) {
+        const size_t writerBits = 16;
+        T q{ args... };
+        std::cout << "Queue object size: " << sizeof(T) << " bytes" << std::endl;
+        //the next sequence expected from each writer under each key
+        std::vector<std::atomic<size_t>> expected(keys * _params.nWriters);
+        std::atomic<size_t> consumed{ 0 };
+        std::atomic<size_t> reordered{ 0 };
+        std::vector<std::thread> l;
+        _startFlag.store(false);
+        _sync.store(0);
+        for (size_t i = 0; i < _params.nReaders; ++i) {
+            l.emplace_back([&, i]() {
+                ++_sync;
+                while (!_startFlag.load(std::memory_order_acquire)) { std::this_thread::yield(); };
+                readers[i].start();
+                auto check = [&](size_t item) {
+                    size_t seq = item >> writerBits;
+                    auto& next = expected[(seq % keys) * _params.nWriters + (item & ((size_t(1) << writerBits) - 1))];
+                    if (next.load(std::memory_order_relaxed) > seq) ++reordered;
+                    next.store(seq + 1, std::memory_order_relaxed);
+                };
+                while (consumed.load(std::memory_order_relaxed) < _params.nElements) {
+                    size_t n = q.consume(check);
+                    if (n) consumed.fetch_add(n, std::memory_order_relaxed);
+                    else std::this_thread::yield();
+                }
+                readers[i].stop();
+            });
+        }
+        for (size_t i = 0; i < _params.nWriters; ++i) {
+            l.emplace_back([&, i]() {
+                ++_sync;
+                while (!_startFlag.load(std::memory_order_acquire)) { std::this_thread::yield(); };
+                writers[i].start();
+                size_t count = _params.nElements / _params.nWriters;
+                if (i == 0) count += _params.nElements - count * _params.nWriters;
+                for (size_t j = 0; j < count; ++j) {
+                    q.mp_enqueue(j % keys, (j << writerBits) | i);
+                }
+                writers[i].stop();
+            });
+        }
+        while (_sync.load() != _params.nWriters + _params.nReaders) { std::this_thread::yield(); };
+        _startFlag.store(true, std::memory_order_release);
+        for (auto& t : l) t.join();
+        EXPECT_EQ(reordered.load(), 0u);
+    }
+
+    //writers fill the ring and the overflow of a hybrid queue before the readers start, the order of every writer's items is checked by each reader
+    template<typename T, typename ...Args>
+    void OverflowTest(Args... args) {
+        const size_t writerBits = 16;
+        T q{ args... };
+        std::atomic<size_t> consumed{ 0 };
+        std::atomic<size_t> reordered{ 0 };
+        std::vector<std::thread> l;
+        for (size_t i = 0; i < _params.nWriters; ++i) {
+            l.emplace_back([&, i]() {
+                writers[i].start();
+                size_t count = _params.nElements / _params.nWriters;
+                if (i == 0) count += _params.nElements - count * _params.nWriters;
+                for (size_t j = 0; j < count; ++j) {
+                    q.mp_enqueue((j << writerBits) | i);
+                }
+                writers[i].stop();
+            });
+        }
+        for (auto& t : l) t.join();
+        l.clear();
+        EXPECT_TRUE(q.overflowing());
+        for (size_t i = 0; i < _params.nReaders; ++i) {
+            l.emplace_back([&, i]() {
+                readers[i].start();
+                std::vector<size_t> next(_params.nWriters, 0);
+                queue_test_type_t item;
+                while (consumed.load(std::memory_order_relaxed) < _params.nElements) {
+                    if (!q.mc_dequeue(item)) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    size_t seq = item >> writerBits;
+                    size_t& writerNext = next[item & ((size_t(1) << writerBits) - 1)];
+                    if (seq < writerNext) ++reordered;
+                    writerNext = seq + 1;
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                }
+                readers[i].stop();
+            });
+        }
+        for (auto& t : l) t.join();
+        queue_test_type_t item;
+        EXPECT_FALSE(q.mc_dequeue(item));
+        EXPECT_FALSE(q.overflowing());
+        EXPECT_EQ(consumed.load(), _params.nElements);
+        EXPECT_EQ(reordered.load(), 0u);
+    }
+
+    //readers dequeue until the writers are done and the queue is empty, every item is either dequeued or counted as dropped
+    template<typename T, typename ...Args>
+    void LossyTest(Args... args) {
+        T q{ args... };
+        std::cout << "Queue object size: " << sizeof(T) << " bytes" << std::endl;
+        std::atomic<size_t> dequeued{ 0 };
+        std::atomic<size_t> writersDone{ 0 };
+        std::vector<std::thread> l;
+        _startFlag.store(false);
+        _sync.store(0);
+        for (size_t i = 0; i < _params.nReaders; ++i) {
+            l.emplace_back([&, i]() {
+                ++_sync;
+                while (!_startFlag.load(std::memory_order_acquire)) { std::this_thread::yield(); };
+                readers[i].start();
+                queue_test_type_t res;
+                while (true) {
+                    bool done = writersDone.load(std::memory_order_acquire) == _params.nWriters;
+                    if (q.mc_dequeue(res)) ++dequeued;
+                    else if (done) break;
+                    else std::this_thread::yield();
+                }
+                readers[i].stop();
+            });
+        }
+        for (size_t i = 0; i < _params.nWriters; ++i) {
+            l.emplace_back([&, i]() {
+                ++_sync;
+                while (!_startFlag.load(std::memory_order_acquire)) { std::this_thread::yield(); };
+                writers[i].start();
+                size_t count = _params.nElements / _params.nWriters;
+                if (i == 0) count += _params.nElements - count * _params.nWriters;
+                for (size_t j = 0; j < count; ++j) {
+                    q.mp_enqueue(j);
+                }
+                writers[i].stop();
+                writersDone.fetch_add(1, std::memory_order_release);
+            });
+        }
+        while (_sync.load() != _params.nWriters + _params.nReaders) { std::this_thread::yield(); };
+        _startFlag.store(true, std::memory_order_release);
+        for (auto& t : l) t.join();
+        std::cout << "Items dequeued: " << dequeued.load() << ", dropped: " << q.dropped() << std::endl;
+        EXPECT_EQ(dequeued.load() + q.dropped(), _params.nElements);
+    }
+
+    //writers enqueue updates under keys and readers dequeue them until the writers are done and the queue is empty
+    //reports how many updates were delivered, and checks that the latest update of every key was delivered
+    //writers join, enqueue and leave for a number of rounds, after which the items are drained
+    //a dynamic multi queue must reuse the subqueues of departed writers rather than add more
+    template<typename T, typename ...Args>
+    void RejoinTest(size_t rounds, Args... args) {
+        T q{ args... };
+        const size_t perWriter = 16;
+        for (size_t round = 0; round < rounds; ++round) {
+            std::vector<std::thread> l;
+            for (size_t i = 0; i < _params.nWriters; ++i) {
+                l.emplace_back([&]() {
+                    for (size_t j = 0; j < perWriter; ++j) {
+                        EXPECT_TRUE(q.mp_enqueue(j));
+                    }
+                });
+            }
+            for (auto& t : l) t.join();
+            queue_test_type_t res;
+            size_t dequeued = 0;
+            while (q.mc_dequeue(res)) ++dequeued;
+            EXPECT_EQ(dequeued, perWriter * _params.nWriters);
+            ASSERT_LE(q.subqueue_count(), _params.nWriters);
+        }
+        std::cout << "Subqueues after " << rounds << " rounds: " << q.subqueue_count() << std::endl;
+    }
+
+    //two writers taking turns at enqueueing must fan the queue out, and one writer enqueueing alone must then collapse it
+    template<typename T, typename ...Args>
+    void AdaptTest(Args... args) {
+        T q{ args... };
+        //one sample per batch of each writer
+        const size_t batch = 256;
+        const size_t turns = 64;
+        auto run_batch = [&]() {
+            for (size_t j = 0; j < batch; ++j) q.mp_enqueue(j);
+            queue_test_type_t res;
+            for (size_t j = 0; j < batch; ++j) EXPECT_TRUE(q.mc_dequeue(res));
+        };
+        std::atomic<size_t> turn{ 0 };
+        std::vector<std::thread> l;
+        for (size_t i = 0; i < 2; ++i) {
+            l.emplace_back([&, i]() {
+                for (size_t t = i; t < turns; t += 2) {
+                    while (turn.load(std::memory_order_acquire) != t) { std::this_thread::yield(); }
+                    run_batch();
+                    turn.store(t + 1, std::memory_order_release);
+                }
+            });
+        }
+        for (auto& t : l) t.join();
+        EXPECT_TRUE(q.fanned_out());
+        for (size_t t = 0; t < turns; ++t) run_batch();
+        EXPECT_FALSE(q.fanned_out());
+    }
+
+    template<typename T, typename ...Args>
+    void ConflatingTest(size_t keys, Args... args) {
+        const size_t writerBits = 16;
+        T q{ args... };
+        std::cout << "Queue object size: " << sizeof(T) << " bytes" << std::endl;
+        //the newest sequence delivered from each writer under each key, plus one
+        std::vector<std::atomic<size_t>> delivered(keys * _params.nWriters);
+        std::vector<size_t> written(keys * _params.nWriters, 0);
+        std::atomic<size_t> deliveries{ 0 };
+        std::atomic<size_t> writersDone{ 0 };
+        std::vector<std::thread> l;
+        _startFlag.store(false);
+        _sync.store(0);
+        for (size_t i = 0; i < _params.nReaders; ++i) {
+            l.emplace_back([&, i]() {
+                ++_sync;
+                while (!_startFlag.load(std::memory_order_acquire)) { std::this_thread::yield(); };
+                readers[i].start();
+                size_t key, value;
+                while (true) {
+                    bool done = writersDone.load(std::memory_order_acquire) == _params.nWriters;
+                    if (!q.mc_dequeue(key, value)) {
+                        if (done) break;
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    ++deliveries;
+                    auto& newest = delivered[key * _params.nWriters + (value & ((size_t(1) << writerBits) - 1))];
+                    size_t seq = (value >> writerBits) + 1;
+                    size_t prev = newest.load(std::memory_order_relaxed);
+                    while (seq > prev && !newest.compare_exchange_weak(prev, seq, std::memory_order_relaxed));
+                }
+                readers[i].stop();
+            });
+        }
+        for (size_t i = 0; i < _params.nWriters; ++i) {
+            l.emplace_back([&, i]() {
+                ++_sync;
+                while (!_startFlag.load(std::memory_order_acquire)) { std::this_thread::yield(); };
+                writers[i].start();
+                size_t count = _params.nElements / _params.nWriters;
+                if (i == 0) count += _params.nElements - count * _params.nWriters;
+                for (size_t j = 0; j < count; ++j) {
+                    q.mp_enqueue(j % keys, (j << writerBits) | i);
+                    written[(j % keys) * _params.nWriters + i] = j + 1;
+                }
+                writers[i].stop();
+                writersDone.fetch_add(1, std::memory_order_release);
+            });
+        }
+        while (_sync.load() != _params.nWriters + _params.nReaders) { std::this_thread::yield(); };
+        _startFlag.store(true, std::memory_order_release);
+        for (auto& t : l) t.join();
+        std::cout << "Updates delivered: " << deliveries.load() << " of " << _params.nElements << std::endl;
+        //the update written last to a key is always delivered, whichever writer wrote it
+        size_t missing = 0;
+        for (size_t k = 0; k < keys; ++k) {
+            bool found = false;
+            bool any = false;
+            for (size_t w = 0; w < _params.nWriters; ++w) {
+                any |= written[k * _params.nWriters + w] != 0;
+                found |= written[k * _params.nWriters + w] != 0 && delivered[k * _params.nWriters + w].load() == written[k * _params.nWriters + w];
+            }
+            if (any && !found) ++missing;
+        }
+        EXPECT_EQ(missing, 0u);
+    }
+
+    //writers push timestamps through a pipeline of cheap stages, each run by a thread per reader, and readers pop them
+    //reports the end-to-end throughput and the latency of the items
+    template<typename T, typename ...Args>
+    void PipelineTest(size_t stages, Args... args) {
+        auto start = std::chrono::steady_clock::now();
+        auto stamp = [start]() {
+            return static_cast<size_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        };
+        T p{ args... };
+        for (size_t i = 0; i < stages; ++i) {
+            p.add_stage(_params.nReaders, [](size_t& item) { ++item; });
+        }
+        p.start();
+        std::atomic<size_t> popped{ 0 };
+        std::atomic<size_t> totalLatency{ 0 };
+        std::atomic<size_t> maxLatency{ 0 };
+        std::vector<std::thread> l;
+        _startFlag.store(false);
+        _sync.store(0);
+        for (size_t i = 0; i < _params.nReaders; ++i) {
+            l.emplace_back([&, i]() {
+                ++_sync;
+                while (!_startFlag.load(std::memory_order_acquire)) { std::this_thread::yield(); };
+                readers[i].start();
+                size_t item;
+                while (popped.load(std::memory_order_relaxed) < _params.nElements) {
+                    if (!p.pop(item)) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    ++popped;
+                    size_t latency = stamp() - (item - stages);
+                    totalLatency.fetch_add(latency, std::memory_order_relaxed);
+                    size_t prev = maxLatency.load(std::memory_order_relaxed);
+                    while (latency > prev && !maxLatency.compare_exchange_weak(prev, latency, std::memory_order_relaxed));
+                }
+                readers[i].stop();
+            });
+        }
+        for (size_t i = 0; i < _params.nWriters; ++i) {
+            l.emplace_back([&, i]() {
+                ++_sync;
+                while (!_startFlag.load(std::memory_order_acquire)) { std::this_thread::yield(); };
+                writers[i].start();
+                size_t count = _params.nElements / _params.nWriters;
+                if (i == 0) count += _params.nElements - count * _params.nWriters;
+                for (size_t j = 0; j < count; ++j) {
+                    if constexpr (std::is_same<decltype(p.push(stamp())), bool>::value) {
+                        while (!p.push(stamp())) { std::this_thread::yield(); }
+                    }
+                    else {
+                        p.push(stamp());
+                    }
+                }
+                if constexpr (std::is_same<decltype(p.flush()), bool>::value) {
+                    while (!p.flush()) { std::this_thread::yield(); }
+                }
+                else {
+                    p.flush();
+                }
+                writers[i].stop();
+            });
+        }
+        while (_sync.load() != _params.nWriters + _params.nReaders) { std::this_thread::yield(); };
+        auto begin = std::chrono::steady_clock::now();
+        _startFlag.store(true, std::memory_order_release);
+        for (auto& t : l) t.join();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        p.stop();
+        EXPECT_TRUE(p.finished());
+        std::cout << "End-to-end throughput: " << _params.nElements / elapsed.count() << " items/second" << std::endl;
+        std::cout << "Average latency: " << totalLatency.load() / _params.nElements / 1000.0 << " microseconds" << std::endl;
+        std::cout << "Max latency: " << maxLatency.load() / 1000.0 << " microseconds" << std::endl;
+    }
+
     auto generateBusyDequeue() {
         return ([](auto& q, auto& item) {
             while (!q.mc_dequeue(item));
@@ -233,6 +627,17 @@ protected:
         GenericTest(dequeueFunction, enqueueFunction, false, args...);
     }
 
+    template<typename T, typename R, typename... Args>
+    typename std::enable_if_t<std::is_base_of<bk_conq::unbounded_queue_typed_tag<R>, T>::value>
+        TemplatedSojournTest(Args&&... args) {
+        SojournTest<T, R>(generateDequeueFunctionNonblocking<T, R>(), generateEnqueueFunctionBlocking<T, R>(), args...);
+    }
+
+    template<typename T, typename R, typename... Args>
+    typename std::enable_if_t<std::is_base_of<bk_conq::bounded_queue_typed_tag<R>, T>::value>
+        TemplatedSojournTest(Args&&... args) {
+        SojournTest<T, R>(generateDequeueFunctionNonblocking<T, R>(), generateEnqueueFunctionNonblocking<T, R>(), _params.queueSize, args...);
+    }
 
     template <typename T, typename R, typename... Args>
     typename std::enable_if_t<std::is_base_of<bk_conq::unbounded_queue_typed_tag<R>, T>::value>
@@ -251,4 +656,25 @@ protected:
     }
 
 };
+
+//test items narrowed to 32 bits through a queue Q of uint32_t, such as a vector queue packing them into one word per slot
+template <typename Q>
+struct narrow_qtype : bk_conq::bounded_queue_typed_tag<QueueTest::queue_test_type_t>, bk_conq::bounded_queue_tag {
+    using queue_t = Q;
+
+    narrow_qtype(size_t N) : _q(N) {}
+
+    bool mp_enqueue(QueueTest::queue_test_type_t item) {
+        return _q.mp_enqueue(static_cast<uint32_t>(item));
+    }
+
+    bool mc_dequeue(QueueTest::queue_test_type_t& item) {
+        uint32_t narrow;
+        if (!_q.mc_dequeue(narrow)) return false;
+        item = narrow;
+        return true;
+    }
+
+    queue_t _q;
+};
 #endif /* CONCURRENT_QUEUE_TEST_H */
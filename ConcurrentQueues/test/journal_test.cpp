@@ -0,0 +1,177 @@
+#include "concurrent_queue_test.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <bk_conq/journal.hpp>
+
+//writers append records to a journal and every reader tails all of them
+namespace Journal {
+
+//a directory in the temporary directory, removed with everything in it
+struct journal_directory {
+    journal_directory(const std::string& name) :
+        path((std::filesystem::temp_directory_path() / (name + "_" + std::to_string(getpid()))).string())
+    {
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directory(path);
+    }
+
+    ~journal_directory() {
+        std::filesystem::remove_all(path);
+    }
+
+    const std::string path;
+};
+
+//the start of every record, the rest of the record is padding
+struct record_prefix {
+    uint64_t writer;
+    uint64_t sequence;
+    int64_t timestamp;
+};
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//checks that every reader sees the records of each writer in order, and reports the latency from append to read
+void ThroughputTest(const TestParameters& params, std::vector<basic_timer>& readers, std::vector<basic_timer>& writers, size_t record_bytes) {
+    journal_directory directory("bk_conq_journal_" + std::to_string(record_bytes));
+    std::atomic<bool> startFlag{ false };
+    std::atomic<bool> failed{ false };
+    std::vector<int64_t> latencySum(params.nReaders, 0);
+    std::vector<int64_t> latencyMax(params.nReaders, 0);
+    std::vector<std::thread> l;
+    for (size_t i = 0; i < params.nReaders; ++i) {
+        l.emplace_back([&, i]() {
+            bk_conq::journal_tailer tailer(directory.path);
+            std::vector<uint64_t> next(params.nWriters, 0);
+            while (!startFlag.load(std::memory_order_acquire)) std::this_thread::yield();
+            readers[i].start();
+            for (size_t j = 0; j < params.nElements; ) {
+                bool read = tailer.read([&](const char* data, size_t length) {
+                    record_prefix prefix;
+                    std::memcpy(&prefix, data, sizeof(prefix));
+                    int64_t latency = now_ns() - prefix.timestamp;
+                    latencySum[i] += latency;
+                    latencyMax[i] = std::max(latencyMax[i], latency);
+                    if (length != record_bytes || prefix.writer >= params.nWriters || prefix.sequence != next[prefix.writer]++) failed = true;
+                });
+                if (read) ++j;
+                else std::this_thread::yield();
+            }
+            readers[i].stop();
+        });
+    }
+    for (size_t i = 0; i < params.nWriters; ++i) {
+        l.emplace_back([&, i]() {
+            bk_conq::journal_appender appender(directory.path);
+            std::vector<char> record(record_bytes, 0);
+            size_t count = params.nElements / params.nWriters;
+            if (i == 0) count += params.nElements % params.nWriters;
+            while (!startFlag.load(std::memory_order_acquire)) std::this_thread::yield();
+            writers[i].start();
+            for (size_t j = 0; j < count; ++j) {
+                record_prefix prefix{ i, j, now_ns() };
+                std::memcpy(record.data(), &prefix, sizeof(prefix));
+                appender.append(record.data(), record.size());
+            }
+            writers[i].stop();
+        });
+    }
+    startFlag.store(true, std::memory_order_release);
+    for (auto& t : l) t.join();
+    EXPECT_FALSE(failed.load());
+    int64_t sum = 0;
+    int64_t max = 0;
+    for (size_t i = 0; i < params.nReaders; ++i) {
+        sum += latencySum[i];
+        max = std::max(max, latencyMax[i]);
+    }
+    std::cout << "Record size: " << record_bytes << " bytes" << std::endl;
+    std::cout << "Average append to read latency: " << static_cast<double>(sum) / (params.nElements * params.nReaders) << " nanoseconds" << std::endl;
+    std::cout << "Max append to read latency: " << max << " nanoseconds" << std::endl;
+}
+
+TEST_P(QueueTest, journal_64b) {
+    ThroughputTest(_params, readers, writers, 64);
+}
+
+TEST_P(QueueTest, journal_1kb) {
+    ThroughputTest(_params, readers, writers, 1024);
+}
+
+//small files so that the records roll over several files
+TEST_P(QueueTest, journal_restart) {
+    journal_directory directory("bk_conq_journal_restart");
+    bk_conq::journal_appender appender(directory.path, 4096);
+    for (uint64_t i = 0; i < 1000; ++i) appender.append(&i, sizeof(i));
+    uint64_t item = 0;
+    auto read = [&](const char* data, size_t length) {
+        ASSERT_EQ(length, sizeof(item));
+        std::memcpy(&item, data, length);
+    };
+    bk_conq::journal_position saved;
+    {
+        bk_conq::journal_tailer tailer(directory.path);
+        for (uint64_t i = 0; i < 400; ++i) {
+            ASSERT_TRUE(tailer.read(read));
+            EXPECT_EQ(item, i);
+        }
+        saved = tailer.position();
+    }
+    bk_conq::journal_tailer tailer(directory.path, saved);
+    for (uint64_t i = 400; i < 1000; ++i) {
+        ASSERT_TRUE(tailer.read(read));
+        EXPECT_EQ(item, i);
+    }
+    EXPECT_FALSE(tailer.read(read));
+    EXPECT_GT(tailer.position().file, 0u);
+    //an appender opened later continues the same journal
+    bk_conq::journal_appender later(directory.path, 4096);
+    uint64_t last = 1000;
+    later.append(&last, sizeof(last));
+    ASSERT_TRUE(tailer.read(read));
+    EXPECT_EQ(item, 1000u);
+}
+
+//a forked process appends while this one tails
+TEST_P(QueueTest, journal_two_process) {
+    journal_directory directory("bk_conq_journal_two_process");
+    const size_t n = _params.nElements;
+    //the first file exists before the fork so the tailer can open it
+    bk_conq::journal_appender appender(directory.path, size_t(1) << 20);
+    pid_t pid = fork();
+    if (pid == 0) {
+        bk_conq::journal_appender child(directory.path, size_t(1) << 20);
+        for (uint64_t i = 0; i < n; ++i) child.append(&i, sizeof(i));
+        _exit(0);
+    }
+    ASSERT_GT(pid, 0);
+    bk_conq::journal_tailer tailer(directory.path);
+    uint64_t expected = 0;
+    bool inOrder = true;
+    readers[0].start();
+    while (expected < n) {
+        bool read = tailer.read([&](const char* data, size_t length) {
+            uint64_t item;
+            std::memcpy(&item, data, sizeof(item));
+            inOrder = inOrder && length == sizeof(item) && item == expected;
+            ++expected;
+        });
+        if (!read) std::this_thread::yield();
+    }
+    readers[0].stop();
+    writers[0] = readers[0];
+    int status = 0;
+    waitpid(pid, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    EXPECT_TRUE(inOrder);
+}
+
+}
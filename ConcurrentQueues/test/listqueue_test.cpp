@@ -1,10 +1,215 @@
 #include "concurrent_queue_test.h"
+#include <fstream>
+#include <unordered_map>
+#ifdef __linux__
+#include <malloc.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 namespace ListQueue {
 using qtype = bk_conq::list_queue<QueueTest::queue_test_type_t>;
 using mqtype = bk_conq::multi_unbounded_queue<qtype>;
 using bqtype = bk_conq::blocking_unbounded_queue<qtype>;
 using bmqtype = bk_conq::blocking_unbounded_queue<mqtype>;
+using cqtype = bk_conq::list_queue<QueueTest::queue_test_type_t, bk_conq::compact_layout>;
+using mcqtype = bk_conq::multi_unbounded_queue<cqtype, bk_conq::compact_layout>;
+using smqtype = bk_conq::static_multi_unbounded_queue<qtype, 16>;
+using dmqtype = bk_conq::dynamic_multi_unbounded_queue<qtype>;
+using aqtype = bk_conq::adaptive_unbounded_queue<qtype>;
+using btqtype = bk_conq::batching_unbounded_queue<bk_conq::list_queue<bk_conq::batch<QueueTest::queue_test_type_t, 32>>>;
+using pqtype = bk_conq::partitioned_queue<qtype, size_t>;
+using plqtype = bk_conq::pipeline<bk_conq::list_queue<bk_conq::batch<QueueTest::queue_test_type_t, 32>>>;
+
+//serves the subqueues round robin every 64 dequeues
+struct fair_mqtype : mqtype {
+    fair_mqtype(size_t subqueues) : mqtype(subqueues) {
+        set_fairness_interval(64);
+    }
+};
+
+//the alternative to the partitioned queue, a single queue and a dispatcher thread
+//routing each key to the queue of the consumer that owns it
+class dispatched_qtype {
+public:
+    dispatched_qtype(size_t consumers) : _out(consumers) {
+        for (auto& q : _out) q = std::make_unique<qtype>();
+        _dispatcher = std::thread([this]() { dispatch(); });
+    }
+
+    ~dispatched_qtype() {
+        _done.store(true);
+        _dispatcher.join();
+    }
+
+    void mp_enqueue(size_t key, QueueTest::queue_test_type_t item) {
+        _in.mp_enqueue(std::make_pair(key, item));
+    }
+
+    template <typename F>
+    size_t consume(F&& f, size_t max_items = 64) {
+        thread_local size_t consumer = _next_consumer++ % _out.size();
+        size_t count = 0;
+        QueueTest::queue_test_type_t item;
+        while (count < max_items && _out[consumer]->sc_dequeue(item)) {
+            ++count;
+            f(item);
+        }
+        return count;
+    }
+
+private:
+    void dispatch() {
+        std::pair<size_t, QueueTest::queue_test_type_t> keyed;
+        while (!_done.load(std::memory_order_relaxed)) {
+            if (_in.sc_dequeue(keyed)) _out[keyed.first % _out.size()]->sp_enqueue(keyed.second);
+            else std::this_thread::yield();
+        }
+    }
+
+    bk_conq::list_queue<std::pair<size_t, QueueTest::queue_test_type_t>> _in;
+    std::vector<std::unique_ptr<qtype>> _out;
+    std::atomic<size_t> _next_consumer{ 0 };
+    std::atomic<bool> _done{ false };
+    std::thread _dispatcher;
+};
+
+//the alternative to the conflating queue, consumers drain a batch of updates from a single
+//queue and drop every update that a later one in the batch supersedes
+class filtered_qtype {
+public:
+    void mp_enqueue(size_t key, QueueTest::queue_test_type_t value) {
+        _q.mp_enqueue(std::make_pair(key, value));
+    }
+
+    bool mc_dequeue(size_t& key, QueueTest::queue_test_type_t& value) {
+        thread_local std::vector<std::pair<size_t, QueueTest::queue_test_type_t>> latest;
+        thread_local std::unordered_map<size_t, size_t> position;
+        thread_local size_t next = 0;
+        if (next == latest.size()) {
+            latest.clear();
+            position.clear();
+            next = 0;
+            std::pair<size_t, QueueTest::queue_test_type_t> update;
+            for (size_t i = 0; i < 4096 && _q.mc_dequeue(update); ++i) {
+                auto it = position.find(update.first);
+                if (it == position.end()) {
+                    position.emplace(update.first, latest.size());
+                    latest.push_back(update);
+                }
+                else {
+                    latest[it->second].second = update.second;
+                }
+            }
+            if (latest.empty()) return false;
+        }
+        key = latest[next].first;
+        value = latest[next].second;
+        ++next;
+        return true;
+    }
+
+private:
+    bk_conq::list_queue<std::pair<size_t, QueueTest::queue_test_type_t>> _q;
+};
+
+//the resident set size of the process, or 0 where it cannot be read
+size_t resident_bytes() {
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0;
+    size_t resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+const size_t connectionQueues = 10000;
+
+//each burst of traffic goes to one of a hot 1% of the connection queues that moves on every phase, or one at random
+//a writer dequeues its own burst, so there are no reader timings, timers may be null
+template <typename Q>
+void connection_traffic(std::vector<std::unique_ptr<Q>>& queues, size_t nWriters, size_t nElements, std::vector<basic_timer>* writers) {
+    const size_t hotQueues = 100;
+    const size_t burst = 256;
+    const size_t phases = 10;
+    const size_t bursts = nElements / burst / nWriters;
+    std::atomic<bool> startFlag{ false };
+    std::vector<std::thread> l;
+    for (size_t i = 0; i < nWriters; ++i) {
+        l.emplace_back([&, i]() {
+            uint64_t x = i * 2654435761u + 1;
+            while (!startFlag.load(std::memory_order_acquire)) std::this_thread::yield();
+            if (writers) (*writers)[i].start();
+            for (size_t j = 0; j < bursts; ++j) {
+                x ^= x << 13;
+                x ^= x >> 7;
+                x ^= x << 17;
+                size_t phase = j * phases / bursts;
+                Q& q = *queues[(x % 10 != 0) ? (phase * hotQueues + (x >> 8) % hotQueues) % queues.size() : (x >> 8) % queues.size()];
+                for (size_t k = 0; k < burst; ++k) q.mp_enqueue(k);
+                QueueTest::queue_test_type_t item;
+                for (size_t k = 0; k < burst; ) {
+                    if (q.mc_dequeue(item)) ++k;
+                    else std::this_thread::yield();
+                }
+            }
+            if (writers) (*writers)[i].stop();
+        });
+    }
+    startFlag.store(true, std::memory_order_release);
+    for (auto& t : l) t.join();
+}
+
+//reports the resident memory of the connection queues when created and after traffic
+//the memory is measured in a child forked for the purpose, which first returns the free heap of the test process
+//to the system, so that pages freed by earlier tests are not reused by the queues without showing in the count
+template <typename MAKE>
+void connection_memory(const TestParameters& params, MAKE&& make) {
+#ifdef __linux__
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        malloc_trim(0);
+        size_t resident[3];
+        resident[0] = resident_bytes();
+        std::vector<std::unique_ptr<qtype>> queues;
+        for (size_t i = 0; i < connectionQueues; ++i) queues.push_back(make());
+        resident[1] = resident_bytes();
+        connection_traffic(queues, params.nWriters, params.nElements, nullptr);
+        resident[2] = resident_bytes();
+        bool written = write(fds[1], resident, sizeof(resident)) == static_cast<ssize_t>(sizeof(resident));
+        //skip the destructors of the objects copied from the parent
+        _exit(written ? 0 : 1);
+    }
+    ASSERT_GT(pid, 0);
+    close(fds[1]);
+    size_t resident[3];
+    bool read_all = read(fds[0], resident, sizeof(resident)) == static_cast<ssize_t>(sizeof(resident));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    ASSERT_TRUE(read_all && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    std::cout << "Resident memory of " << connectionQueues << " queues when created: " << (resident[1] - resident[0]) / 1024 << " KB" << std::endl;
+    std::cout << "Resident memory of " << connectionQueues << " queues after traffic: " << (resident[2] - resident[0]) / 1024 << " KB" << std::endl;
+#else
+    std::cout << "Resident memory of " << connectionQueues << " queues: not measured" << std::endl;
+#endif
+}
+
+//measures the memory of connection traffic over 10000 queues in a child, then times the writers of the same traffic
+//the child is forked first, so that it does not start from the nodes the timed traffic leaves on a shared pool
+template <typename MAKE>
+void ConnectionTest(const TestParameters& params, std::vector<basic_timer>& writers, MAKE&& make) {
+    connection_memory(params, make);
+    std::vector<std::unique_ptr<qtype>> queues;
+    for (size_t i = 0; i < connectionQueues; ++i) queues.push_back(make());
+    connection_traffic(queues, params.nWriters, params.nElements, &writers);
+}
 
 TEST_P(QueueTest, list_queue) {
     QueueTest::TemplatedTest<qtype, queue_test_type_t>(false);
@@ -38,4 +243,102 @@ TEST_P(QueueTest, multi_list_queue_blocking_prefill) {
     QueueTest::BlockingTest<bmqtype, queue_test_type_t>(true, _params.subqueueSize);
 }
 
-}
\ No newline at end of file
+TEST_P(QueueTest, list_queue_compact) {
+    QueueTest::TemplatedTest<cqtype, queue_test_type_t>(false);
+}
+
+TEST_P(QueueTest, multi_list_queue_compact) {
+    QueueTest::TemplatedTest<mcqtype, queue_test_type_t>(false, _params.subqueueSize);
+}
+
+TEST_P(QueueTest, static_multi_list_queue) {
+    QueueTest::TemplatedTest<smqtype, queue_test_type_t>(false);
+}
+
+TEST_P(QueueTest, multi_list_queue_sojourn) {
+    QueueTest::TemplatedSojournTest<mqtype, queue_test_type_t>(_params.subqueueSize);
+}
+
+TEST_P(QueueTest, multi_list_queue_fair_sojourn) {
+    QueueTest::TemplatedSojournTest<fair_mqtype, queue_test_type_t>(_params.subqueueSize);
+}
+
+TEST_P(QueueTest, dynamic_multi_list_queue) {
+    QueueTest::TemplatedTest<dmqtype, queue_test_type_t>(false, _params.subqueueSize);
+}
+
+TEST_P(QueueTest, adaptive_list_queue) {
+    QueueTest::TemplatedTest<aqtype, queue_test_type_t>(false, _params.subqueueSize);
+}
+
+TEST_P(QueueTest, adaptive_list_queue_switch) {
+    QueueTest::AdaptTest<aqtype>(_params.subqueueSize);
+}
+
+TEST_P(QueueTest, batching_list_queue) {
+    QueueTest::TemplatedTest<btqtype, queue_test_type_t>(false);
+}
+
+//a single producer enqueues while short lived consumers return the rest of their batches as they exit, no item may be lost
+TEST(BatchingListQueue, batching_list_queue_consumers_exit) {
+    const size_t nElements = 200000;
+    btqtype q;
+    std::atomic<bool> producerDone{ false };
+    std::atomic<size_t> dequeued{ 0 };
+    std::atomic<size_t> sum{ 0 };
+    std::thread producer([&]() {
+        for (size_t i = 0; i < nElements; ++i) q.sp_enqueue(i);
+        q.flush();
+        producerDone.store(true, std::memory_order_release);
+    });
+    while (true) {
+        bool done = producerDone.load(std::memory_order_acquire);
+        size_t round = 0;
+        //each consumer takes a few items of a batch and returns the others when it exits
+        std::thread consumer([&]() {
+            QueueTest::queue_test_type_t item;
+            for (size_t j = 0; j < 5 && q.mc_dequeue(item); ++j) {
+                sum.fetch_add(item, std::memory_order_relaxed);
+                ++round;
+            }
+        });
+        consumer.join();
+        dequeued.fetch_add(round, std::memory_order_relaxed);
+        if (done && round == 0) break;
+    }
+    producer.join();
+    EXPECT_EQ(dequeued.load(), nElements);
+    EXPECT_EQ(sum.load(), nElements * (nElements - 1) / 2);
+}
+
+TEST_P(QueueTest, partitioned_list_queue) {
+    QueueTest::KeyedTest<pqtype>(1024, _params.subqueueSize);
+}
+
+TEST_P(QueueTest, dispatched_list_queue) {
+    QueueTest::KeyedTest<dispatched_qtype>(1024, _params.nReaders);
+}
+
+TEST_P(QueueTest, pipeline_list_queue) {
+    QueueTest::PipelineTest<plqtype>(4);
+}
+
+TEST_P(QueueTest, filtered_list_queue) {
+    QueueTest::ConflatingTest<filtered_qtype>(1024);
+}
+
+TEST_P(QueueTest, list_queue_pooled) {
+    QueueTest::TemplatedTest<qtype, queue_test_type_t>(false, std::make_shared<qtype::pool_type>());
+}
+
+TEST_P(QueueTest, list_queue_connections) {
+    ConnectionTest(_params, writers, []() { return std::make_unique<qtype>(); });
+}
+
+TEST_P(QueueTest, list_queue_pooled_connections) {
+    auto pool = std::make_shared<qtype::pool_type>();
+    ConnectionTest(_params, writers, [&]() { return std::make_unique<qtype>(pool); });
+    std::cout << "Pool nodes allocated: " << pool->nodes_allocated() << std::endl;
+}
+
+}
@@ -0,0 +1,103 @@
+#include "concurrent_queue_test.h"
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <bk_conq/shm_vector_queue.hpp>
+
+//a single writer process and a single reader process, the writer is forked from the test process
+namespace ShmQueue {
+using qtype = bk_conq::shm_vector_queue<QueueTest::queue_test_type_t>;
+using cqtype = bk_conq::shm_vector_queue<QueueTest::queue_test_type_t, bk_conq::compact_layout>;
+using bigqtype = bk_conq::shm_vector_queue<BigThing>;
+
+//runs produce in a child process and consume in this one, and returns what consume returns
+template <typename P, typename C>
+size_t two_process(P&& produce, C&& consume) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        produce();
+        //skip the destructors of the objects copied from the parent
+        _exit(0);
+    }
+    EXPECT_GT(pid, 0);
+    size_t ret = consume();
+    int status = 0;
+    waitpid(pid, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    return ret;
+}
+
+TEST_P(QueueTest, shm_vector_queue_two_process) {
+    const std::string name = "/bk_conq_test_" + std::to_string(getpid());
+    const size_t n = _params.nElements;
+    qtype q(name, _params.queueSize);
+    readers[0].start();
+    size_t sum = two_process([&]() {
+        qtype attached(name);
+        for (size_t i = 1; i <= n; ++i) {
+            while (!attached.sp_enqueue(i)) std::this_thread::yield();
+        }
+    }, [&]() {
+        size_t sum = 0;
+        queue_test_type_t item;
+        for (size_t i = 0; i < n; ++i) {
+            while (!q.sc_dequeue(item)) std::this_thread::yield();
+            sum += item;
+        }
+        return sum;
+    });
+    readers[0].stop();
+    writers[0] = readers[0];
+    EXPECT_EQ(sum, n * (n + 1) / 2);
+}
+
+//the path the shared memory queue replaces, one write per item over a unix domain socket
+TEST_P(QueueTest, socket_two_process) {
+    const size_t n = _params.nElements;
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    readers[0].start();
+    size_t sum = two_process([&]() {
+        close(fds[0]);
+        for (size_t i = 1; i <= n; ++i) {
+            if (write(fds[1], &i, sizeof(i)) != sizeof(i)) _exit(1);
+        }
+        close(fds[1]);
+    }, [&]() {
+        close(fds[1]);
+        size_t sum = 0;
+        queue_test_type_t item;
+        for (size_t i = 0; i < n; ++i) {
+            size_t received = 0;
+            while (received < sizeof(item)) {
+                ssize_t r = read(fds[0], reinterpret_cast<char*>(&item) + received, sizeof(item) - received);
+                if (r <= 0) return sum;
+                received += static_cast<size_t>(r);
+            }
+            sum += item;
+        }
+        close(fds[0]);
+        return sum;
+    });
+    readers[0].stop();
+    writers[0] = readers[0];
+    EXPECT_EQ(sum, n * (n + 1) / 2);
+}
+
+TEST(ShmQueue, shm_vector_queue_attach_mismatch) {
+    const std::string name = "/bk_conq_test_mismatch_" + std::to_string(getpid());
+    const size_t queueSize = 1024;
+    qtype q(name, queueSize);
+    EXPECT_THROW(bigqtype{ name }, std::runtime_error);
+    EXPECT_THROW(cqtype{ name }, std::runtime_error);
+    EXPECT_THROW(qtype(name, queueSize), std::system_error);
+    EXPECT_THROW(qtype("/bk_conq_test_missing_" + std::to_string(getpid())), std::system_error);
+    qtype attached(name);
+    EXPECT_TRUE(q.mp_enqueue(42));
+    QueueTest::queue_test_type_t item = 0;
+    EXPECT_TRUE(attached.mc_dequeue(item));
+    EXPECT_EQ(item, 42u);
+}
+
+}
@@ -0,0 +1,89 @@
+#include "concurrent_queue_test.h"
+#include <filesystem>
+#include <string>
+#include <bk_conq/disk_queue.hpp>
+#include <bk_conq/spill_queue.hpp>
+
+namespace SpillQueue {
+//segment files go to the temporary directory
+struct qtype : bk_conq::spill_queue<QueueTest::queue_test_type_t> {
+    qtype(size_t ring_size) : bk_conq::spill_queue<QueueTest::queue_test_type_t>(std::filesystem::temp_directory_path().string(), ring_size) {}
+};
+
+struct dqtype : bk_conq::disk_queue<QueueTest::queue_test_type_t> {
+    dqtype() : bk_conq::disk_queue<QueueTest::queue_test_type_t>(std::filesystem::temp_directory_path().string()) {}
+};
+
+TEST_P(QueueTest, spill_queue) {
+    QueueTest::TemplatedTest<qtype, queue_test_type_t>(false, _params.queueSize);
+}
+
+//the prefill runs the benchmark twice, with readers throughout, so it seldom spills to disk
+TEST_P(QueueTest, spill_queue_prefill) {
+    QueueTest::TemplatedTest<qtype, queue_test_type_t>(true, _params.queueSize);
+}
+
+//every item is enqueued before any is dequeued, so all but the ring and two chunks of them are spilled to disk
+TEST(SpillQueue, spill_queue_spills_in_order) {
+    const size_t ringSize = 1024;
+    const size_t chunkItems = 1024;
+    const size_t n = ringSize + 16 * chunkItems;
+    bk_conq::spill_queue<QueueTest::queue_test_type_t> q(std::filesystem::temp_directory_path().string(), ringSize, chunkItems);
+    for (size_t i = 0; i < n; ++i) q.sp_enqueue(i);
+    EXPECT_TRUE(q.overflowing());
+    EXPECT_GT(q.segments_on_disk(), 0u);
+    QueueTest::queue_test_type_t item;
+    for (size_t i = 0; i < n; ++i) {
+        ASSERT_TRUE(q.sc_dequeue(item));
+        ASSERT_EQ(item, i);
+    }
+    EXPECT_FALSE(q.sc_dequeue(item));
+    EXPECT_EQ(q.segments_on_disk(), 0u);
+}
+
+//producers hand small chunks to the writer while consumers load segments, each consumer sees every producer's items in order
+TEST(SpillQueue, disk_queue_writer_in_order) {
+    const size_t writerBits = 8;
+    const size_t nWriters = 2;
+    const size_t nReaders = 2;
+    const size_t perWriter = 100000;
+    bk_conq::disk_queue<QueueTest::queue_test_type_t> q(std::filesystem::temp_directory_path().string(), 256);
+    std::atomic<size_t> writersDone{ 0 };
+    std::atomic<size_t> dequeued{ 0 };
+    std::atomic<size_t> reordered{ 0 };
+    std::vector<std::thread> l;
+    for (size_t i = 0; i < nReaders; ++i) {
+        l.emplace_back([&]() {
+            std::vector<size_t> next(nWriters, 0);
+            QueueTest::queue_test_type_t item;
+            while (true) {
+                bool done = writersDone.load(std::memory_order_acquire) == nWriters;
+                if (q.mc_dequeue(item)) {
+                    size_t seq = item >> writerBits;
+                    size_t& writerNext = next[item & ((size_t(1) << writerBits) - 1)];
+                    if (seq < writerNext) ++reordered;
+                    writerNext = seq + 1;
+                    dequeued.fetch_add(1, std::memory_order_relaxed);
+                }
+                else if (done) break;
+                else std::this_thread::yield();
+            }
+        });
+    }
+    for (size_t i = 0; i < nWriters; ++i) {
+        l.emplace_back([&, i]() {
+            for (size_t j = 0; j < perWriter; ++j) q.mp_enqueue((j << writerBits) | i);
+            writersDone.fetch_add(1, std::memory_order_release);
+        });
+    }
+    for (auto& t : l) t.join();
+    EXPECT_EQ(dequeued.load(), nWriters * perWriter);
+    EXPECT_EQ(reordered.load(), 0u);
+    EXPECT_EQ(q.segments_on_disk(), 0u);
+}
+
+TEST_P(QueueTest, disk_queue) {
+    QueueTest::TemplatedTest<dqtype, queue_test_type_t>(false);
+}
+
+}
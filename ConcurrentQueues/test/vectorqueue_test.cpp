@@ -1,10 +1,164 @@
 #include "concurrent_queue_test.h"
+#include <cstring>
 
 namespace VectorQueue {
 using qtype = bk_conq::vector_queue<QueueTest::queue_test_type_t>;
 using mqtype = bk_conq::multi_bounded_queue<qtype>;
 using bqtype = bk_conq::blocking_bounded_queue<qtype>;
 using bmqtype = bk_conq::blocking_bounded_queue<mqtype>;
+using cqtype = bk_conq::vector_queue<QueueTest::queue_test_type_t, bk_conq::compact_layout>;
+using sqtype = bk_conq::vector_queue<QueueTest::queue_test_type_t, bk_conq::isolated_slot_layout>;
+using mcqtype = bk_conq::multi_bounded_queue<cqtype, bk_conq::compact_layout>;
+using gqtype = bk_conq::growable_vector_queue<QueueTest::queue_test_type_t>;
+using svqtype = bk_conq::static_vector_queue<QueueTest::queue_test_type_t, 8192>;
+using smqtype = bk_conq::static_multi_bounded_queue<qtype, 16>;
+using spmqtype = bk_conq::spilling_multi_bounded_queue<qtype>;
+using bspmqtype = bk_conq::blocking_bounded_queue<spmqtype>;
+using dmqtype = bk_conq::dynamic_multi_bounded_queue<qtype>;
+using aqtype = bk_conq::adaptive_bounded_queue<qtype>;
+using btqtype = bk_conq::batching_bounded_queue<bk_conq::vector_queue<bk_conq::batch<QueueTest::queue_test_type_t, 32>>>;
+using plqtype = bk_conq::pipeline<bk_conq::vector_queue<bk_conq::batch<QueueTest::queue_test_type_t, 32>>>;
+using cfqtype = bk_conq::conflating_queue<size_t, QueueTest::queue_test_type_t>;
+using lqtype = bk_conq::lossy_vector_queue<QueueTest::queue_test_type_t>;
+using hqtype = bk_conq::hybrid_queue<qtype, bk_conq::list_queue<QueueTest::queue_test_type_t>>;
+
+//large items filled in and read out of a vector queue of BigThing
+struct big_qtype : bk_conq::bounded_queue_typed_tag<QueueTest::queue_test_type_t>, bk_conq::bounded_queue_tag {
+    big_qtype(size_t N) : _q(N) {}
+
+    bool mp_enqueue(QueueTest::queue_test_type_t item) {
+        BigThing big(item);
+        std::memset(big.padding, static_cast<char>(item), sizeof(big.padding));
+        return _q.mp_enqueue(std::move(big));
+    }
+
+    bool mc_dequeue(QueueTest::queue_test_type_t& item) {
+        BigThing big;
+        if (!_q.mc_dequeue(big)) return false;
+        item = big.value;
+        return true;
+    }
+
+    bk_conq::vector_queue<BigThing> _q;
+};
+
+//the same items filled in and read in place through reserved and acquired slots
+struct big_slot_qtype : bk_conq::bounded_queue_typed_tag<QueueTest::queue_test_type_t>, bk_conq::bounded_queue_tag {
+    big_slot_qtype(size_t N) : _q(N) {}
+
+    bool mp_enqueue(QueueTest::queue_test_type_t item) {
+        auto slot = _q.mp_try_reserve();
+        if (!slot) return false;
+        slot->value = item;
+        std::memset(slot->padding, static_cast<char>(item), sizeof(slot->padding));
+        _q.commit(slot);
+        return true;
+    }
+
+    bool mc_dequeue(QueueTest::queue_test_type_t& item) {
+        auto slot = _q.mc_try_acquire();
+        if (!slot) return false;
+        item = slot->value;
+        _q.release(slot);
+        return true;
+    }
+
+    bk_conq::vector_queue<BigThing> _q;
+};
+
+//a variable length message of 8 to 64 bytes per item, the item is in the first 8 bytes
+inline size_t message_length(QueueTest::queue_test_type_t item) {
+    return sizeof(item) + (item % 8) * 8;
+}
+
+//messages written and read in place in a byte ring of 64 bytes per item of queue size
+struct byte_ring_qtype : bk_conq::bounded_queue_typed_tag<QueueTest::queue_test_type_t>, bk_conq::bounded_queue_tag {
+    byte_ring_qtype(size_t N) : _ring(N * 64) {}
+
+    bool mp_enqueue(QueueTest::queue_test_type_t item) {
+        char* data = _ring.mp_reserve(message_length(item));
+        if (!data) return false;
+        std::memcpy(data, &item, sizeof(item));
+        std::memset(data + sizeof(item), 0, message_length(item) - sizeof(item));
+        _ring.commit(data);
+        return true;
+    }
+
+    bool mc_dequeue(QueueTest::queue_test_type_t& item) {
+        bk_conq::byte_ring<>::record message;
+        if (!_ring.mc_peek(message)) return false;
+        std::memcpy(&item, message.data, sizeof(item));
+        _ring.mc_release(message);
+        return true;
+    }
+
+    bk_conq::byte_ring<> _ring;
+};
+
+//the alternative to the byte ring, a heap allocated vector per message
+struct vector_message_qtype : bk_conq::bounded_queue_typed_tag<QueueTest::queue_test_type_t>, bk_conq::bounded_queue_tag {
+    vector_message_qtype(size_t N) : _q(N) {}
+
+    bool mp_enqueue(QueueTest::queue_test_type_t item) {
+        std::vector<char> message(message_length(item), 0);
+        std::memcpy(message.data(), &item, sizeof(item));
+        return _q.mp_enqueue(std::move(message));
+    }
+
+    bool mc_dequeue(QueueTest::queue_test_type_t& item) {
+        std::vector<char> message;
+        if (!_q.mc_dequeue(message)) return false;
+        std::memcpy(&item, message.data(), sizeof(item));
+        return true;
+    }
+
+    bk_conq::vector_queue<std::vector<char>> _q;
+};
+
+//an item of BYTES bytes, the item is in the first 8 bytes
+template <size_t BYTES>
+struct payload {
+    char bytes[BYTES];
+};
+
+//items of BYTES bytes through a vector queue, where they are held inline, or a slab queue, where they are held out of line
+template <template <typename> class Q, size_t BYTES>
+struct payload_qtype : bk_conq::bounded_queue_typed_tag<QueueTest::queue_test_type_t>, bk_conq::bounded_queue_tag {
+    payload_qtype(size_t N) : _q(N) {}
+
+    bool mp_enqueue(QueueTest::queue_test_type_t item) {
+        payload<BYTES> p;
+        std::memcpy(p.bytes, &item, sizeof(item));
+        std::memset(p.bytes + sizeof(item), static_cast<char>(item), BYTES - sizeof(item));
+        return _q.mp_enqueue(p);
+    }
+
+    bool mc_dequeue(QueueTest::queue_test_type_t& item) {
+        payload<BYTES> p;
+        if (!_q.mc_dequeue(p)) return false;
+        std::memcpy(&item, p.bytes, sizeof(item));
+        return true;
+    }
+
+    Q<payload<BYTES>> _q;
+};
+
+template <typename T>
+using inline_queue = bk_conq::vector_queue<T>;
+
+template <typename T>
+using slab_queue = bk_conq::slab_queue<T>;
+
+//32 bit items through a vector queue of uint32_t, packed into one word per slot unless PACKED is false
+template <typename LAYOUT, bool PACKED>
+using vnarrow_qtype = narrow_qtype<bk_conq::vector_queue<uint32_t, LAYOUT, PACKED>>;
+
+//serves the subqueues round robin every 64 dequeues
+struct fair_mqtype : mqtype {
+    fair_mqtype(size_t N, size_t subqueues) : mqtype(N, subqueues) {
+        set_fairness_interval(64);
+    }
+};
 
 TEST_P(QueueTest, vector_queue) {
     QueueTest::TemplatedTest<qtype, queue_test_type_t>();
@@ -22,4 +176,264 @@ TEST_P(QueueTest, multi_vector_queue_blocking) {
     QueueTest::BlockingTest<bmqtype, queue_test_type_t>(_params.subqueueSize);
 }
 
-}
\ No newline at end of file
+TEST_P(QueueTest, vector_queue_compact) {
+    QueueTest::TemplatedTest<cqtype, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, vector_queue_padded_slots) {
+    QueueTest::TemplatedTest<sqtype, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, multi_vector_queue_compact) {
+    QueueTest::TemplatedTest<mcqtype, queue_test_type_t>(_params.subqueueSize);
+}
+
+TEST_P(QueueTest, growable_vector_queue) {
+    QueueTest::TemplatedBoundedTest<gqtype, queue_test_type_t>(size_t(1024), _params.queueSize);
+}
+
+TEST_P(QueueTest, static_vector_queue) {
+    QueueTest::TemplatedBoundedTest<svqtype, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, static_multi_vector_queue) {
+    QueueTest::TemplatedTest<smqtype, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, multi_vector_queue_spill) {
+    QueueTest::TemplatedTest<spmqtype, queue_test_type_t>(_params.subqueueSize);
+}
+
+TEST_P(QueueTest, multi_vector_queue_spill_blocking) {
+    QueueTest::BlockingTest<bspmqtype, queue_test_type_t>(_params.subqueueSize);
+}
+
+TEST_P(QueueTest, multi_vector_queue_sojourn) {
+    QueueTest::TemplatedSojournTest<mqtype, queue_test_type_t>(_params.subqueueSize);
+}
+
+TEST_P(QueueTest, multi_vector_queue_fair_sojourn) {
+    QueueTest::TemplatedSojournTest<fair_mqtype, queue_test_type_t>(_params.subqueueSize);
+}
+
+TEST_P(QueueTest, dynamic_multi_vector_queue) {
+    QueueTest::TemplatedTest<dmqtype, queue_test_type_t>(_params.subqueueSize);
+}
+
+TEST_P(QueueTest, dynamic_multi_vector_queue_rejoin) {
+    QueueTest::RejoinTest<dmqtype>(64, _params.queueSize, _params.nWriters * 2);
+}
+
+TEST_P(QueueTest, adaptive_vector_queue) {
+    QueueTest::TemplatedTest<aqtype, queue_test_type_t>(_params.subqueueSize);
+}
+
+TEST_P(QueueTest, adaptive_vector_queue_switch) {
+    QueueTest::AdaptTest<aqtype>(_params.queueSize, _params.subqueueSize);
+}
+
+TEST_P(QueueTest, batching_vector_queue) {
+    QueueTest::TemplatedTest<btqtype, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, pipeline_vector_queue) {
+    QueueTest::PipelineTest<plqtype>(4, _params.queueSize);
+}
+
+TEST_P(QueueTest, conflating_queue) {
+    QueueTest::ConflatingTest<cfqtype>(1024, size_t(1024));
+}
+
+TEST(ConflatingQueue, size_must_be_power_of_2) {
+    EXPECT_THROW(cfqtype(0), std::length_error);
+    EXPECT_THROW(cfqtype(1000), std::length_error);
+    EXPECT_NO_THROW(cfqtype(1024));
+}
+
+//many consumers dequeue the keys of a two slot queue while each producer updates its own key, the last update of every key must be delivered
+TEST(ConflatingQueue, conflating_queue_many_consumers) {
+    const size_t nWriters = 2;
+    const size_t nReaders = 8;
+    const size_t perWriter = 100000;
+    cfqtype q(nWriters);
+    std::atomic<size_t> writersDone{ 0 };
+    std::vector<std::atomic<size_t>> latest(nWriters);
+    for (auto& l : latest) l.store(0);
+    std::vector<std::thread> l;
+    for (size_t i = 0; i < nReaders; ++i) {
+        l.emplace_back([&]() {
+            size_t key;
+            QueueTest::queue_test_type_t value;
+            while (true) {
+                bool done = writersDone.load(std::memory_order_acquire) == nWriters;
+                if (q.mc_dequeue(key, value)) {
+                    size_t seen = latest[key].load(std::memory_order_relaxed);
+                    while (seen < value && !latest[key].compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+                }
+                else if (done) break;
+                else std::this_thread::yield();
+            }
+        });
+    }
+    for (size_t i = 0; i < nWriters; ++i) {
+        l.emplace_back([&, i]() {
+            for (size_t j = 1; j <= perWriter; ++j) {
+                EXPECT_TRUE(q.mp_enqueue(i, j));
+            }
+            writersDone.fetch_add(1, std::memory_order_release);
+        });
+    }
+    for (auto& t : l) t.join();
+    for (size_t i = 0; i < nWriters; ++i) {
+        EXPECT_EQ(latest[i].load(), perWriter);
+    }
+}
+
+TEST_P(QueueTest, lossy_vector_queue) {
+    QueueTest::LossyTest<lqtype>(_params.queueSize);
+}
+
+TEST_P(QueueTest, hybrid_vector_queue) {
+    QueueTest::TemplatedTest<hqtype, queue_test_type_t>(false, _params.queueSize);
+}
+
+TEST_P(QueueTest, hybrid_vector_queue_prefill) {
+    QueueTest::TemplatedTest<hqtype, queue_test_type_t>(true, _params.queueSize);
+}
+
+TEST_P(QueueTest, hybrid_vector_queue_overflow) {
+    QueueTest::OverflowTest<hqtype>(size_t(1024));
+}
+
+TEST_P(QueueTest, byte_ring) {
+    QueueTest::TemplatedTest<byte_ring_qtype, queue_test_type_t>();
+}
+
+//a ring filled to capacity is claimed by several consumers holding their records, each record is claimed once
+TEST(ByteRing, byte_ring_claims_full_ring) {
+    bk_conq::byte_ring<> ring(64);
+    const size_t length = 24;
+    for (size_t lap = 0; lap < 4; ++lap) {
+        for (size_t i = 0; i < 2; ++i) {
+            char* data = ring.mp_reserve(length);
+            ASSERT_NE(data, nullptr);
+            std::memset(data, static_cast<int>(i), length);
+            ring.commit(data);
+        }
+        EXPECT_EQ(ring.mp_reserve(length), nullptr);
+        std::vector<bk_conq::byte_ring<>::record> claimed;
+        for (size_t consumer = 0; consumer < 3; ++consumer) {
+            bk_conq::byte_ring<>::record message;
+            if (ring.mc_peek(message)) claimed.push_back(message);
+        }
+        ASSERT_EQ(claimed.size(), 2u);
+        EXPECT_EQ(claimed[0].position, lap * 64);
+        EXPECT_EQ(claimed[1].position, lap * 64 + 32);
+        EXPECT_EQ(claimed[0].data[0], 0);
+        EXPECT_EQ(claimed[1].data[0], 1);
+        //released out of order, the space is only reclaimed with the first record
+        ring.mc_release(claimed[1]);
+        EXPECT_EQ(ring.mp_reserve(length), nullptr);
+        ring.mc_release(claimed[0]);
+    }
+}
+
+TEST_P(QueueTest, vector_message_queue) {
+    QueueTest::TemplatedTest<vector_message_qtype, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, vector_queue_big) {
+    QueueTest::TemplatedTest<big_qtype, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, vector_queue_big_slots) {
+    QueueTest::TemplatedTest<big_slot_qtype, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, vector_queue_payload_8b) {
+    QueueTest::TemplatedTest<payload_qtype<inline_queue, 8>, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, slab_queue_payload_8b) {
+    QueueTest::TemplatedTest<payload_qtype<slab_queue, 8>, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, vector_queue_payload_64b) {
+    QueueTest::TemplatedTest<payload_qtype<inline_queue, 64>, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, slab_queue_payload_64b) {
+    QueueTest::TemplatedTest<payload_qtype<slab_queue, 64>, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, vector_queue_payload_512b) {
+    QueueTest::TemplatedTest<payload_qtype<inline_queue, 512>, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, slab_queue_payload_512b) {
+    QueueTest::TemplatedTest<payload_qtype<slab_queue, 512>, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, vector_queue_payload_4kb) {
+    QueueTest::TemplatedTest<payload_qtype<inline_queue, 4096>, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, slab_queue_payload_4kb) {
+    QueueTest::TemplatedTest<payload_qtype<slab_queue, 4096>, queue_test_type_t>();
+}
+
+//many consumers give indices back to a slab of a few slots while producers take them, no item may be lost
+TEST(SlabQueue, slab_queue_many_consumers) {
+    const size_t slabSize = 4;
+    const size_t nWriters = 2;
+    const size_t nReaders = 8;
+    const size_t perWriter = 100000;
+    bk_conq::slab_queue<QueueTest::queue_test_type_t> q(slabSize);
+    std::atomic<size_t> writersDone{ 0 };
+    std::atomic<size_t> dequeued{ 0 };
+    std::atomic<size_t> sum{ 0 };
+    std::vector<std::thread> l;
+    for (size_t i = 0; i < nReaders; ++i) {
+        l.emplace_back([&]() {
+            QueueTest::queue_test_type_t item;
+            while (true) {
+                bool done = writersDone.load(std::memory_order_acquire) == nWriters;
+                if (q.mc_dequeue(item)) {
+                    dequeued.fetch_add(1, std::memory_order_relaxed);
+                    sum.fetch_add(item, std::memory_order_relaxed);
+                }
+                else if (done) break;
+                else std::this_thread::yield();
+            }
+        });
+    }
+    for (size_t i = 0; i < nWriters; ++i) {
+        l.emplace_back([&]() {
+            for (size_t j = 0; j < perWriter; ++j) {
+                while (!q.mp_enqueue(j)) std::this_thread::yield();
+            }
+            writersDone.fetch_add(1, std::memory_order_release);
+        });
+    }
+    for (auto& t : l) t.join();
+    EXPECT_EQ(dequeued.load(), nWriters * perWriter);
+    EXPECT_EQ(sum.load(), nWriters * (perWriter * (perWriter - 1) / 2));
+}
+
+TEST_P(QueueTest, vector_queue_packed) {
+    QueueTest::TemplatedTest<vnarrow_qtype<bk_conq::isolated_layout, true>, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, vector_queue_unpacked) {
+    QueueTest::TemplatedTest<vnarrow_qtype<bk_conq::isolated_layout, false>, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, vector_queue_packed_compact) {
+    QueueTest::TemplatedTest<vnarrow_qtype<bk_conq::compact_layout, true>, queue_test_type_t>();
+}
+
+TEST_P(QueueTest, vector_queue_unpacked_compact) {
+    QueueTest::TemplatedTest<vnarrow_qtype<bk_conq::compact_layout, false>, queue_test_type_t>();
+}
+
+}